@@ -0,0 +1,87 @@
+// =========================================================
+// FEC 重配置回归检查
+//
+// 控制器运行中经 fec_reconfigure / fec_set_loss_rate 在 RS 与 XOR 组之间
+// 切换，编码矩阵必须随 ds:ps 重建。逐个场景编码一组、丢掉与校验数
+// 相同个数的数据分片，再用新建的解码引擎恢复并与原数据比对：
+//   gcc -O2 -Isrc -o /tmp/fec_check scripts/fec_reconfigure_check.c src/v3_fec_simd.c src/v3_cpu_dispatch.c -lpthread
+//   /tmp/fec_check
+//
+// 全部通过返回 0，否则打印失败场景并返回 1
+// =========================================================
+#include "v3_fec_simd.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CHECK_LEN   3000    // 不超过 3 个数据分片的容量，各场景通用
+
+static uint8_t shards[FEC_MAX_TOTAL_SHARDS][FEC_SHARD_SIZE];
+static size_t  lens[FEC_MAX_TOTAL_SHARDS];
+static uint8_t data[CHECK_LEN];
+static uint8_t out[FEC_MAX_DATA_SHARDS * FEC_SHARD_SIZE];
+
+// 编码一组，丢掉前 n - ds 个数据分片后解码，结果与原数据一致返回 true
+static bool roundtrip(fec_engine_t *tx, fec_type_t type) {
+    uint32_t gid;
+    int n = fec_encode(tx, data, CHECK_LEN, shards, lens, &gid);
+    if (n <= 0) return false;
+    int ds = shards[0][5];
+    
+    fec_engine_t *rx = fec_create(type, 5, 2);
+    if (!rx) return false;
+    
+    bool ok = false;
+    for (int k = n - ds; k < n; k++) {
+        uint32_t g;
+        uint8_t idx;
+        size_t out_len = 0;
+        if (fec_parse_header(shards[k], lens[k], &g, &idx) < 0) break;
+        if (fec_decode(rx, g, idx, shards[k], lens[k], out, &out_len) == 1) {
+            ok = out_len == CHECK_LEN && memcmp(out, data, CHECK_LEN) == 0;
+            break;
+        }
+    }
+    fec_destroy(rx);
+    return ok;
+}
+
+int main(void) {
+    static const fec_type_t types[] = { FEC_TYPE_RS_SIMPLE, FEC_TYPE_RS_SIMD, FEC_TYPE_RS_CAUCHY };
+    static const char *names[] = { "RS-Simple", "RS-SIMD", "RS-Cauchy" };
+    
+    // 场景：初始 5:2，先切到 XOR 组（ds 改变），再回到 RS 或只调冗余率
+    static const struct {
+        const char *desc;
+        uint8_t     xor_ds;
+        uint8_t     rs_ds, rs_ps;       // rs_ds 为 0 表示改用 fec_set_loss_rate
+    } cases[] = {
+        { "5:2 -> XOR 3 -> RS 3:2",             3, 3, 2 },
+        { "5:2 -> XOR 8 -> RS 8:2",             8, 8, 2 },
+        { "5:2 -> XOR 4 -> RS 4:3",             4, 4, 3 },
+        { "5:2 -> XOR 8 -> set_loss_rate(0.01)", 8, 0, 0 },
+    };
+    
+    for (int i = 0; i < CHECK_LEN; i++) {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+    
+    int failed = 0;
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            fec_engine_t *e = fec_create(types[t], 5, 2);
+            bool ok = e && fec_reconfigure(e, FEC_TYPE_XOR, cases[c].xor_ds, 0) == 0;
+            if (ok && cases[c].rs_ds) {
+                ok = fec_reconfigure(e, types[t], cases[c].rs_ds, cases[c].rs_ps) == 0;
+            } else if (ok) {
+                fec_set_loss_rate(e, 0.01f);
+            }
+            ok = ok && roundtrip(e, types[t]);
+            if (e) fec_destroy(e);
+    
+            printf("%-10s %-38s %s\n", names[t], cases[c].desc, ok ? "OK" : "FAIL");
+            if (!ok) failed++;
+        }
+    }
+    
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+// =========================================================
+// GF(2^8) 查找表生成器
+//
+// 生成 src/v3_gf_tables.h（编译期常量表，进程间通过页缓存共享）：
+//   gcc -O2 -o /tmp/gen_gf_tables scripts/gen_gf_tables.c
+//   /tmp/gen_gf_tables > src/v3_gf_tables.h
+//
+// 修改本原多项式或 gf_coef_t 布局时需重新生成
+// =========================================================
+#include <stdint.h>
+#include <stdio.h>
+
+#define GF_POLY 0x11d
+
+static uint8_t gf_exp[512];
+static uint8_t gf_log[256];
+static uint8_t gf_mul_table[256][256];
+
+static void build(void) {
+    int x = 1;
+    for (int i = 0; i < 255; i++) {
+        gf_exp[i] = x;
+        gf_log[x] = i;
+        x <<= 1;
+        if (x & 0x100) x ^= GF_POLY;
+    }
+    for (int i = 255; i < 512; i++) {
+        gf_exp[i] = gf_exp[i - 255];
+    }
+    gf_log[0] = 0;
+    
+    for (int a = 0; a < 256; a++) {
+        for (int b = 0; b < 256; b++) {
+            gf_mul_table[a][b] = (a && b) ? gf_exp[gf_log[a] + gf_log[b]] : 0;
+        }
+    }
+}
+
+// 仿射矩阵第 i 行（字节 7-i）：c * 2^j 的第 i 位构成的掩码
+static uint64_t affine_of(int c) {
+    uint64_t m = 0;
+    for (int i = 0; i < 8; i++) {
+        uint8_t row = 0;
+        for (int j = 0; j < 8; j++) {
+            if (gf_mul_table[1 << j][c] & (1 << i)) row |= 1 << j;
+        }
+        m |= (uint64_t)row << (8 * (7 - i));
+    }
+    return m;
+}
+
+static void emit_bytes(const uint8_t *p, int n, const char *indent) {
+    for (int i = 0; i < n; i++) {
+        if (i % 16 == 0) printf("%s", indent);
+        printf("0x%02x,", p[i]);
+        putchar(i % 16 == 15 || i == n - 1 ? '\n' : ' ');
+    }
+}
+
+int main(void) {
+    build();
+    
+    printf("// 自动生成，请勿手工修改 —— 见 scripts/gen_gf_tables.c\n");
+    printf("// GF(2^8)，本原多项式 0x%x\n", GF_POLY);
+    printf("// 仅供 v3_fec_simd.c 包含（依赖其中的 gf_coef_t 定义）\n");
+    printf("#ifndef V3_GF_TABLES_H\n#define V3_GF_TABLES_H\n\n");
+    
+    printf("static const uint8_t gf_exp[512] = {\n");
+    emit_bytes(gf_exp, 512, "    ");
+    printf("};\n\n");
+    
+    printf("static const uint8_t gf_log[256] = {\n");
+    emit_bytes(gf_log, 256, "    ");
+    printf("};\n\n");
+    
+    // 完整乘法表（64 KB，空间换时间）
+    printf("static const uint8_t gf_mul_table[256][256] = {\n");
+    for (int a = 0; a < 256; a++) {
+        printf("    { // 0x%02x\n", a);
+        emit_bytes(gf_mul_table[a], 256, "        ");
+        printf("    },\n");
+    }
+    printf("};\n\n");
+    
+    // 每个系数的 16 项半字节表 + GFNI 仿射矩阵
+    printf("static const gf_coef_t gf_coef[256] = {\n");
+    for (int c = 0; c < 256; c++) {
+        uint8_t lo[16], hi[16];
+        for (int n = 0; n < 16; n++) {
+            lo[n] = gf_mul_table[n][c];
+            hi[n] = gf_mul_table[n << 4][c];
+        }
+        printf("    { // 0x%02x\n        .lo = {", c);
+        for (int n = 0; n < 16; n++) printf("0x%02x%s", lo[n], n < 15 ? "," : "},\n");
+        printf("        .hi = {");
+        for (int n = 0; n < 16; n++) printf("0x%02x%s", hi[n], n < 15 ? "," : "},\n");
+        printf("        .affine = 0x%016llxULL, .c = 0x%02x,\n    },\n",
+               (unsigned long long)affine_of(c), c);
+    }
+    printf("};\n\n");
+    
+    printf("#endif // V3_GF_TABLES_H\n");
+    return 0;
+}
@@ -12,20 +12,38 @@ static cpu_level_t g_cpu_level = CPU_LEVEL_GENERIC;
 static bool g_detected = false;
 
 #ifdef __x86_64__
+// 读取 XCR0，确认操作系统保存了 YMM/ZMM 寄存器状态
+static uint64_t read_xcr0(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+
 static void detect_x86(void) {
     unsigned int eax, ebx, ecx, edx;
+    bool os_ymm = false, os_zmm = false;
     
     if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
         if (edx & bit_SSE2)  g_cpu_features |= CPU_FEATURE_SSE2;
-        if (ecx & bit_AVX)   g_cpu_features |= CPU_FEATURE_AVX;
+        if (ecx & bit_SSSE3) g_cpu_features |= CPU_FEATURE_SSSE3;
+        if (ecx & bit_OSXSAVE) {
+            uint64_t xcr0 = read_xcr0();
+            os_ymm = (xcr0 & 0x06) == 0x06;
+            os_zmm = (xcr0 & 0xE6) == 0xE6;
+        }
+        if ((ecx & bit_AVX) && os_ymm) g_cpu_features |= CPU_FEATURE_AVX;
     }
     
     if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
-        if (ebx & bit_AVX2)     g_cpu_features |= CPU_FEATURE_AVX2;
-        if (ebx & bit_AVX512F)  g_cpu_features |= CPU_FEATURE_AVX512F;
+        if ((ebx & bit_AVX2) && os_ymm)     g_cpu_features |= CPU_FEATURE_AVX2;
+        if ((ebx & bit_AVX512F) && os_zmm)  g_cpu_features |= CPU_FEATURE_AVX512F;
+        if ((ebx & bit_AVX512BW) && os_zmm) g_cpu_features |= CPU_FEATURE_AVX512BW;
+        if (ecx & bit_GFNI)                 g_cpu_features |= CPU_FEATURE_GFNI;
     }
     
-    if (g_cpu_features & CPU_FEATURE_AVX512F) {
+    // FEC 的 512 位内核需要字节级指令，F 与 BW 缺一不可
+    if ((g_cpu_features & CPU_FEATURE_AVX512F) &&
+        (g_cpu_features & CPU_FEATURE_AVX512BW)) {
         g_cpu_level = CPU_LEVEL_AVX512;
     } else if (g_cpu_features & CPU_FEATURE_AVX2) {
         g_cpu_level = CPU_LEVEL_AVX2;
@@ -41,6 +59,13 @@ static void detect_x86(void) {
 static void detect_arm64(void) {
     g_cpu_features |= CPU_FEATURE_NEON;
     g_cpu_level = CPU_LEVEL_NEON;
+    
+#ifdef HWCAP_SVE
+    if (getauxval(AT_HWCAP) & HWCAP_SVE) {
+        g_cpu_features |= CPU_FEATURE_SVE;
+        g_cpu_level = CPU_LEVEL_SVE;
+    }
+#endif
 }
 #endif
 
@@ -54,6 +79,15 @@ void cpu_detect(void) {
     g_detected = true;
 }
 
+uint32_t cpu_get_features(void) {
+    if (!g_detected) cpu_detect();
+    return g_cpu_features;
+}
+
+bool cpu_has_feature(cpu_feature_t feature) {
+    return (cpu_get_features() & feature) != 0;
+}
+
 cpu_level_t cpu_get_level(void) {
     if (!g_detected) cpu_detect();
     return g_cpu_level;
@@ -65,6 +99,7 @@ const char* cpu_level_name(cpu_level_t level) {
         case CPU_LEVEL_AVX2:    return "AVX2";
         case CPU_LEVEL_AVX512:  return "AVX-512";
         case CPU_LEVEL_NEON:    return "NEON (ARM64)";
+        case CPU_LEVEL_SVE:     return "SVE (ARM64)";
         default:                return "Unknown";
     }
 }
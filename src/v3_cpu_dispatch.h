@@ -19,6 +19,7 @@ typedef enum {
     CPU_FEATURE_AVX512BW  = (1 << 8),
     CPU_FEATURE_NEON      = (1 << 9),
     CPU_FEATURE_SVE       = (1 << 10),
+    CPU_FEATURE_GFNI      = (1 << 11),
 } cpu_feature_t;
 
 // =========================================================
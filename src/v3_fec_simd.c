@@ -4,12 +4,14 @@
 
 #define _GNU_SOURCE
 #include "v3_fec_simd.h"
+#include "v3_cpu_dispatch.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #ifdef __x86_64__
-#include <cpuid.h>
 #include <immintrin.h>
 #define HAVE_AVX2 1
 #endif
@@ -19,59 +21,547 @@
 #define HAVE_NEON 1
 #endif
 
+// SVE 内核需要以 +sve 编译（如 -march=armv8.2-a+sve），运行时再按 HWCAP 启用
+#if defined(__aarch64__) && defined(__ARM_FEATURE_SVE)
+#include <arm_sve.h>
+#define HAVE_SVE 1
+#endif
+
 // =========================================================
 // GF(2^8) 基础
 // =========================================================
-static uint8_t gf_exp[512];
-static uint8_t gf_log[256];
-static uint8_t gf_mul_table[256][256];  // 完整乘法表（空间换时间）
-static int gf_initialized = 0;
+// 单个系数的预展开乘法表（SIMD 内核按系数取用）
+typedef struct {
+    // 半字节表：c * x = lo[x & 0x0F] ^ hi[x >> 4]
+    uint8_t  lo[16];
+    uint8_t  hi[16];
+    // GFNI 仿射矩阵：vgf2p8mulb 固定使用 0x11B 多项式，与这里的 0x11D 不同，
+    // 所以把"乘以 c"表示成 8x8 位矩阵，交给 vgf2p8affineqb 计算
+    uint64_t affine;
+    uint8_t  c;
+} gf_coef_t;
 
-static void gf_init(void) {
-    if (gf_initialized) return;
-    
-    // 生成 exp/log 表
-    int x = 1;
-    for (int i = 0; i < 255; i++) {
-        gf_exp[i] = x;
-        gf_log[x] = i;
-        x <<= 1;
-        if (x & 0x100) x ^= 0x11d;
+// gf_exp / gf_log / gf_mul_table / gf_coef 均为编译期常量（只读段，多进程共享页缓存，
+// 无需运行时初始化，也就没有多线程首次调用的竞争），由 scripts/gen_gf_tables.c 生成
+#include "v3_gf_tables.h"
+
+static inline uint64_t get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 区域异或 dst ^= src：向量（x86 SSE2 为基线，编译期启用 AVX2 时 32 字节；
+// ARM NEON）+ 8 字节字 + 字节收尾。memcpy 读写字，不要求对齐
+static inline void xor_region(uint8_t *dst, const uint8_t *src, size_t len) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(a, b));
+    }
+#endif
+#if defined(HAVE_AVX2)
+    for (; i + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(a, b));
+    }
+#elif defined(HAVE_NEON)
+    for (; i + 16 <= len; i += 16) {
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < len; i++) {
+        dst[i] ^= src[i];
     }
-    for (int i = 255; i < 512; i++) {
-        gf_exp[i] = gf_exp[i - 255];
+}
+
+// dst ^= c * src（无 SIMD 时的标量内核）
+// 按系数取 gf_mul_table[c] 这一行（256 字节，4 条缓存线）查表，整段数据只
+// 触及这一行；按数据字节取行则每字节落在 64 KB 表的不同行，L1 不断换出。
+// 8 字节一组展开：一次读写一个字，8 次查表互不依赖
+static void gf_mul_xor_scalar(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) {
+    if (c == 0) return;
+    if (c == 1) {
+        xor_region(dst, src, len);
+        return;
     }
-    gf_log[0] = 0;
     
-    // 预计算完整乘法表
-    for (int a = 0; a < 256; a++) {
-        for (int b = 0; b < 256; b++) {
-            if (a == 0 || b == 0) {
-                gf_mul_table[a][b] = 0;
-            } else {
-                gf_mul_table[a][b] = gf_exp[gf_log[a] + gf_log[b]];
-            }
+    const uint8_t *row = gf_mul_table[c];
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t s, d;
+        memcpy(&s, src + i, 8);
+        memcpy(&d, dst + i, 8);
+        // 读写同一字节序，移位位置与字节位置一一对应，与大小端无关
+        d ^= (uint64_t)row[s & 0xFF]
+           | (uint64_t)row[(s >> 8) & 0xFF] << 8
+           | (uint64_t)row[(s >> 16) & 0xFF] << 16
+           | (uint64_t)row[(s >> 24) & 0xFF] << 24
+           | (uint64_t)row[(s >> 32) & 0xFF] << 32
+           | (uint64_t)row[(s >> 40) & 0xFF] << 40
+           | (uint64_t)row[(s >> 48) & 0xFF] << 48
+           | (uint64_t)row[s >> 56] << 56;
+        memcpy(dst + i, &d, 8);
+    }
+    for (; i < len; i++) {
+        dst[i] ^= row[src[i]];
+    }
+}
+
+// =========================================================
+// 分片缓冲 slab（所有引擎共享，总量有上限）
+// =========================================================
+// 重组中的组按实际 (ds + ps) x shard_size 申请一块缓冲，组完成或被淘汰时
+// 归还；空闲引擎不占分片内存。对象按大小分级，每级从 FEC_SLAB_PAGE 对齐的
+// 页中切分，对象所在页由地址直接算出。页全空时归还系统（每级保留一页热页）
+#define FEC_SLAB_PAGE           (256 * 1024)
+#define FEC_SLAB_HDR            64          // 页头，对象从此偏移开始
+#define FEC_SLAB_CLASSES        7
+#define FEC_SLAB_DEFAULT_LIMIT  (128u * 1024 * 1024)
+
+// 最大一级容纳 30 x 1408 字节（分片步长按 64 字节取整）
+static const uint32_t slab_class_size[FEC_SLAB_CLASSES] = {
+    2048, 4096, 8192, 16384, 24576, 32768, 49152
+};
+
+typedef struct slab_page_s {
+    struct slab_page_s *next;       // 本级有空闲对象的页
+    struct slab_page_s *prev;
+    void     *free;                 // 页内空闲对象链表
+    uint32_t  used;
+    uint32_t  cls;
+} slab_page_t;
+
+static struct {
+    pthread_mutex_t lock;
+    slab_page_t *partial[FEC_SLAB_CLASSES];
+    size_t   limit;
+    size_t   reserved;
+    size_t   in_use;
+    size_t   peak;
+    uint64_t failures;
+} g_slab = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .limit = FEC_SLAB_DEFAULT_LIMIT,
+};
+
+static int slab_class(size_t size) {
+    for (int c = 0; c < FEC_SLAB_CLASSES; c++) {
+        if (size <= slab_class_size[c]) return c;
+    }
+    return -1;
+}
+
+static inline void slab_unlink(slab_page_t *pg) {
+    if (pg->prev) pg->prev->next = pg->next;
+    else g_slab.partial[pg->cls] = pg->next;
+    if (pg->next) pg->next->prev = pg->prev;
+    pg->next = pg->prev = NULL;
+}
+
+static inline void slab_push(slab_page_t *pg) {
+    pg->prev = NULL;
+    pg->next = g_slab.partial[pg->cls];
+    if (pg->next) pg->next->prev = pg;
+    g_slab.partial[pg->cls] = pg;
+}
+
+// 申请 size 字节，超过上限或内存不足返回 NULL
+static void* slab_alloc(size_t size) {
+    int cls = slab_class(size);
+    if (cls < 0) return NULL;
+    uint32_t obj = slab_class_size[cls];
+    
+    pthread_mutex_lock(&g_slab.lock);
+    slab_page_t *pg = g_slab.partial[cls];
+    if (!pg) {
+        if (g_slab.limit && g_slab.reserved + FEC_SLAB_PAGE > g_slab.limit) goto fail;
+        pg = aligned_alloc(FEC_SLAB_PAGE, FEC_SLAB_PAGE);
+        if (!pg) goto fail;
+        
+        pg->used = 0;
+        pg->cls = cls;
+        pg->free = NULL;
+        uint32_t count = (FEC_SLAB_PAGE - FEC_SLAB_HDR) / obj;
+        for (uint32_t i = count; i-- > 0; ) {
+            void **o = (void**)((uint8_t*)pg + FEC_SLAB_HDR + (size_t)i * obj);
+            *o = pg->free;
+            pg->free = o;
         }
+        slab_push(pg);
+        g_slab.reserved += FEC_SLAB_PAGE;
     }
     
-    gf_initialized = 1;
+    void **o = pg->free;
+    pg->free = *o;
+    pg->used++;
+    if (!pg->free) slab_unlink(pg);
+    
+    g_slab.in_use += obj;
+    if (g_slab.in_use > g_slab.peak) g_slab.peak = g_slab.in_use;
+    pthread_mutex_unlock(&g_slab.lock);
+    return o;
+    
+fail:
+    g_slab.failures++;
+    pthread_mutex_unlock(&g_slab.lock);
+    return NULL;
+}
+
+static void slab_free(void *p) {
+    if (!p) return;
+    slab_page_t *pg = (slab_page_t*)((uintptr_t)p & ~(uintptr_t)(FEC_SLAB_PAGE - 1));
+    
+    pthread_mutex_lock(&g_slab.lock);
+    bool was_full = pg->free == NULL;
+    *(void**)p = pg->free;
+    pg->free = p;
+    pg->used--;
+    g_slab.in_use -= slab_class_size[pg->cls];
+    
+    if (was_full) slab_push(pg);
+    if (pg->used == 0 && (pg->next || pg->prev)) {
+        slab_unlink(pg);
+        g_slab.reserved -= FEC_SLAB_PAGE;
+        free(pg);
+    }
+    pthread_mutex_unlock(&g_slab.lock);
+}
+
+// 组缓冲的实际占用（按级取整）
+static inline size_t slab_size_of(size_t size) {
+    int cls = slab_class(size);
+    return cls < 0 ? 0 : slab_class_size[cls];
+}
+
+void fec_slab_set_limit(size_t bytes) {
+    pthread_mutex_lock(&g_slab.lock);
+    g_slab.limit = bytes;
+    pthread_mutex_unlock(&g_slab.lock);
+}
+
+void fec_slab_get_stats(fec_slab_stats_t *stats) {
+    pthread_mutex_lock(&g_slab.lock);
+    stats->limit = g_slab.limit;
+    stats->reserved = g_slab.reserved;
+    stats->in_use = g_slab.in_use;
+    stats->peak = g_slab.peak;
+    stats->alloc_failures = g_slab.failures;
+    pthread_mutex_unlock(&g_slab.lock);
 }
 
 // =========================================================
-// CPU 能力检测
+// 解码重组表（哈希索引 + 截止时间回收）
 // =========================================================
-bool fec_simd_available(void) {
-#ifdef HAVE_AVX2
-    unsigned int eax, ebx, ecx, edx;
-    if (__get_cpuid(7, &eax, &ebx, &ecx, &edx)) {
-        return (ebx & bit_AVX2) != 0;
+// group_id 哈希到槽位，在 FEC_SLOT_PROBE 个相邻槽内线性探测。
+// 槽位在组完成或超过交付期限后复用；探测窗口全满时淘汰最早到达的组，
+// 不做任何整表搬移。槽位只存元数据，分片缓冲在组的第一个分片到达时从 slab
+// 按该组的分片数与分片大小申请
+//
+// 交付期限从组的第一个分片到达算起。新组到达时顺带（每 1/4 期限至多一次）
+// 扫描全表，过期的组立即放弃：整组输出模式下已到达的数据分片交给 partial
+// 回调，槽位与缓冲释放，组号记入已完成表，之后的分片按迟到丢弃。
+// 无流量时由 fec_decode_expire 定时触发同样的扫描
+#define FEC_SLOT_PROBE              4
+#define FEC_DEFAULT_SLOTS           64
+#define FEC_DEFAULT_GROUP_TIMEOUT   500     // ms
+#define FEC_DONE_SLOTS              1024    // 已完成组的直接映射标记表
+
+typedef struct {
+    uint32_t group_id;
+    bool     in_use;
+    uint8_t  data_count;
+    uint8_t  parity_count;
+    uint8_t  present_count;
+    uint8_t  data_present;      // 已到达的数据分片数
+    bool     recovered;         // 本组有数据分片靠校验恢复
+    bool     stream;            // 流式编码组：数据分片长度逐个记录在 lens
+    bool     has_lens;          // 流式编码组：已从校验分片得到全部长度
+    size_t   shard_size;
+    size_t   payload_len;       // 组负载精确长度（头部带长度时），否则 ds * shard_size
+    uint64_t arrival_ns;        // 第一个分片到达时间
+    bool     present[FEC_MAX_TOTAL_SHARDS];
+    uint16_t lens[FEC_MAX_TOTAL_SHARDS];    // 各分片有效长度（XOR-2D、流式编码组，分片长短不一）
+    uint8_t  *buf;              // slab 缓冲，(data_count + parity_count) 个分片，NULL = 未分配
+    uint32_t stride;            // 分片步长（shard_size 按 64 字节取整）
+} fec_slot_t;
+
+static inline uint8_t* slot_shard(const fec_slot_t *s, int i) {
+    return s->buf + (size_t)i * s->stride;
+}
+
+// 负载按 shard_size 顺序切片时第 i 个数据分片的有效长度
+static inline size_t shard_data_len(size_t payload_len, size_t shard_size, int i) {
+    size_t off = (size_t)i * shard_size;
+    if (off >= payload_len) return 0;
+    return payload_len - off < shard_size ? payload_len - off : shard_size;
+}
+
+// 组内第 i 个数据分片的有效长度：流式编码组按记录的长度
+static inline size_t slot_data_len(const fec_slot_t *s, int i) {
+    return s->stream ? s->lens[i] : shard_data_len(s->payload_len, s->shard_size, i);
+}
+
+typedef struct {
+    fec_slot_t *slots;
+    uint32_t    mask;           // 槽位数 - 1（槽位数为 2 的幂）
+    uint32_t    max_shards;     // 每组分片数上限
+    uint64_t    timeout_ns;     // 交付期限
+    uint64_t    next_sweep_ns;
+    
+    // 放弃的组交付已到达数据分片（整组输出模式），NULL = 不交付
+    fec_deliver_fn flush_fn;
+    void        *flush_user;
+    
+    // 最近完成的组（存 group_id + 1，0 = 空），迟到分片查表即丢弃，
+    // 不会再占用槽位；冲突时覆盖旧记录，最多漏判
+    uint32_t    done[FEC_DONE_SLOTS];
+    
+    // 统计（供自适应控制器）：恢复过的组、未能恢复的组（放弃或解码失败）
+    uint64_t    groups_recovered;
+    uint64_t    groups_failed;
+    uint64_t    groups_abandoned;   // 过期或被淘汰
+    uint64_t    shards_flushed;
+    uint64_t    late_shards;
+    
+    // 内存：持有的 slab 缓冲（按级取整）与正在重组的组数
+    size_t      shard_bytes;
+    uint32_t    groups_active;
+} fec_slot_table_t;
+
+// 归还槽位的分片缓冲
+static void slot_drop_buf(fec_slot_table_t *t, fec_slot_t *s) {
+    if (!s->buf) return;
+    t->shard_bytes -= slab_size_of((size_t)(s->data_count + s->parity_count) * s->stride);
+    t->groups_active--;
+    slab_free(s->buf);
+    s->buf = NULL;
+}
+
+static void slot_table_free(fec_slot_table_t *t) {
+    if (t->slots) {
+        for (uint32_t i = 0; i <= t->mask; i++) slot_drop_buf(t, &t->slots[i]);
     }
-    return false;
-#elif defined(HAVE_NEON)
-    return true;  // ARM64 总是有 NEON
-#else
-    return false;
-#endif
+    free(t->slots);
+    t->slots = NULL;
+}
+
+static int slot_table_init(fec_slot_table_t *t, uint32_t count, uint32_t max_shards) {
+    uint32_t n = 4;
+    while (n < count && n < (1u << 16)) n <<= 1;
+    
+    fec_slot_t *slots = calloc(n, sizeof(fec_slot_t));
+    if (!slots) return -1;
+    
+    slot_table_free(t);
+    t->slots = slots;
+    t->mask = n - 1;
+    t->max_shards = max_shards;
+    return 0;
+}
+
+static inline bool slot_expired(const fec_slot_table_t *t, const fec_slot_t *s, uint64_t now) {
+    return now - s->arrival_ns >= t->timeout_ns;
+}
+
+static void slot_abandon(fec_slot_table_t *t, fec_slot_t *s);
+static int slot_sweep(fec_slot_table_t *t, uint64_t now);
+
+// 查找 group_id 对应的槽位，不存在时分配新槽
+static fec_slot_t* slot_acquire(fec_slot_table_t *t, uint32_t group_id) {
+    uint32_t h = group_id * 2654435761u;
+    uint32_t probe = t->mask + 1 < FEC_SLOT_PROBE ? t->mask + 1 : FEC_SLOT_PROBE;
+    
+    for (uint32_t k = 0; k < probe; k++) {
+        fec_slot_t *s = &t->slots[(h + k) & t->mask];
+        if (s->in_use && s->group_id == group_id) return s;
+    }
+    
+    uint64_t now = get_time_ns();
+    if (now >= t->next_sweep_ns) slot_sweep(t, now);
+    
+    // 新组：优先空槽，否则放弃最早到达的（过期或未过期）
+    fec_slot_t *victim = NULL;
+    for (uint32_t k = 0; k < probe; k++) {
+        fec_slot_t *s = &t->slots[(h + k) & t->mask];
+        if (!s->in_use) {
+            victim = s;
+            break;
+        }
+        if (!victim || s->arrival_ns < victim->arrival_ns) victim = s;
+    }
+    if (victim->in_use) slot_abandon(t, victim);
+    
+    victim->in_use = true;
+    victim->group_id = group_id;
+    victim->present_count = 0;
+    victim->data_present = 0;
+    victim->recovered = false;
+    victim->stream = false;
+    victim->has_lens = false;
+    victim->arrival_ns = now;
+    memset(victim->present, 0, sizeof(victim->present));
+    return victim;
+}
+
+static inline void slot_release(fec_slot_table_t *t, fec_slot_t *s) {
+    slot_drop_buf(t, s);
+    s->in_use = false;
+}
+
+// 组的第一个分片到达时按实际参数申请缓冲；之后的分片参数必须与之一致
+// 返回 0 成功，-1 参数不符或 slab 已满（后者释放槽位，该组丢弃）
+static int slot_prepare(fec_slot_table_t *t, fec_slot_t *s,
+                        uint8_t data_count, uint8_t parity_count, size_t shard_size) {
+    if (s->buf) {
+        return s->data_count == data_count && s->parity_count == parity_count &&
+               s->shard_size == shard_size ? 0 : -1;
+    }
+    
+    uint32_t stride = (shard_size + 63) & ~63u;
+    size_t bytes = (size_t)(data_count + parity_count) * stride;
+    s->buf = slab_alloc(bytes);
+    if (!s->buf) {
+        s->in_use = false;
+        return -1;
+    }
+    
+    s->stride = stride;
+    s->data_count = data_count;
+    s->parity_count = parity_count;
+    s->shard_size = shard_size;
+    t->shard_bytes += slab_size_of(bytes);
+    t->groups_active++;
+    return 0;
+}
+
+// 已完成或已放弃组的迟到分片：计数，调用方直接丢弃
+static inline bool slot_is_late(fec_slot_table_t *t, uint32_t group_id) {
+    if (t->done[(group_id * 2654435761u) & (FEC_DONE_SLOTS - 1)] != group_id + 1) return false;
+    t->late_shards++;
+    return true;
+}
+
+// 组已交付：释放槽位并记下 group_id，之后的迟到分片直接丢弃
+static inline void slot_complete(fec_slot_table_t *t, fec_slot_t *s) {
+    if (s->recovered) t->groups_recovered++;
+    t->done[(s->group_id * 2654435761u) & (FEC_DONE_SLOTS - 1)] = s->group_id + 1;
+    slot_release(t, s);
+}
+
+// 放弃未能恢复的组：交付已到达的数据分片（按精确长度），随后同完成处理
+static void slot_abandon(fec_slot_table_t *t, fec_slot_t *s) {
+    if (t->flush_fn && s->buf) {
+        for (int i = 0; i < s->data_count; i++) {
+            size_t l = slot_data_len(s, i);
+            if (s->present[i] && l > 0) {
+                t->flush_fn(t->flush_user, s->group_id, i, slot_shard(s, i), l);
+                t->shards_flushed++;
+            }
+        }
+    }
+    t->groups_failed++;
+    t->groups_abandoned++;
+    s->recovered = false;
+    slot_complete(t, s);
+}
+
+// 放弃全部过期的组，返回放弃的组数
+static int slot_sweep(fec_slot_table_t *t, uint64_t now) {
+    int n = 0;
+    for (uint32_t i = 0; i <= t->mask; i++) {
+        fec_slot_t *s = &t->slots[i];
+        if (s->in_use && slot_expired(t, s, now)) {
+            slot_abandon(t, s);
+            n++;
+        }
+    }
+    t->next_sweep_ns = now + t->timeout_ns / 4;
+    return n;
+}
+
+// 保存分片（重复到达的分片忽略），返回当前已有分片数
+// 未补齐发送的短数据分片在此按 0 扩展到 shard_size
+static int slot_store(fec_slot_t *s, uint8_t shard_idx,
+                      const uint8_t *data, size_t len) {
+    if (!s->present[shard_idx]) {
+        uint8_t *dst = slot_shard(s, shard_idx);
+        memcpy(dst, data, len);
+        if (len < s->shard_size) memset(dst + len, 0, s->shard_size - len);
+        s->present[shard_idx] = true;
+        s->present_count++;
+        if (shard_idx < s->data_count) s->data_present++;
+    }
+    return s->present_count;
+}
+
+// 流式编码组的校验分片带有全部数据分片的长度（大端 2 字节 x ds）。
+// 长度为 0 的是提前结束的组未使用的分片，按全 0 计为已到达
+static int slot_stream_lens(fec_slot_t *s, const uint8_t *table) {
+    for (int i = 0; i < s->data_count; i++) {
+        if (s->present[i]) continue;
+        s->lens[i] = (table[2 * i] << 8) | table[2 * i + 1];
+        if (s->lens[i] == 0) {
+            memset(slot_shard(s, i), 0, s->shard_size);
+            s->present[i] = true;
+            s->present_count++;
+            s->data_present++;
+        }
+    }
+    s->has_lens = true;
+    return s->present_count;
+}
+
+// =========================================================
+// 分片头（v1，FEC_HEADER_SIZE 字节）
+// =========================================================
+//   [0..3] group_id（大端）
+//   [4]    版本(2) | HAS_LEN(1) | shard_idx(5)
+//   [5..9] 各模式自定义：
+//     RS:    ds,  ps(4) | STREAM(1) | shard_size 高 3 位,  shard_size 低 8 位,  组负载长度(2)
+//     XOR:   gs,  shard_size(2),  组负载长度(2)
+//     滑动:  w,   R,  0,  0,  0
+// shard_size 与负载长度均为精确值；带 HAS_LEN 时接收端按负载长度去掉末尾补齐。
+// 数据分片可以不补齐发送（见 fec_set_unpadded），接收端只在校验运算时按 0 扩展
+#define FEC_HDR_HAS_LEN     0x20
+#define FEC_HDR_IDX_MASK    0x1F
+#define FEC_HDR_RS_STREAM   0x08    // [6]：流式编码组（见 fec_stream_push）
+
+static inline void hdr_write_common(uint8_t *h, uint32_t group_id, uint8_t shard_idx,
+                                    bool has_len) {
+    h[0] = (group_id >> 24) & 0xFF;
+    h[1] = (group_id >> 16) & 0xFF;
+    h[2] = (group_id >> 8) & 0xFF;
+    h[3] = group_id & 0xFF;
+    h[4] = (FEC_HEADER_VERSION << 6) | (has_len ? FEC_HDR_HAS_LEN : 0) |
+           (shard_idx & FEC_HDR_IDX_MASK);
+}
+
+static inline bool hdr_valid(const uint8_t *h, size_t len) {
+    return len >= FEC_HEADER_SIZE && (h[4] >> 6) == FEC_HEADER_VERSION;
+}
+
+static inline bool hdr_has_len(const uint8_t *h) {
+    return h[4] & FEC_HDR_HAS_LEN;
+}
+
+int fec_parse_header(const uint8_t *shard, size_t len,
+                     uint32_t *group_id, uint8_t *shard_idx) {
+    if (!hdr_valid(shard, len)) return -1;
+    *group_id = ((uint32_t)shard[0] << 24) | ((uint32_t)shard[1] << 16) |
+                ((uint32_t)shard[2] << 8) | shard[3];
+    *shard_idx = shard[4] & FEC_HDR_IDX_MASK;
+    return 0;
 }
 
 // =========================================================
@@ -80,122 +570,107 @@ bool fec_simd_available(void) {
 typedef struct {
     uint32_t next_group_id;
     uint8_t  group_size;
-    
-    // 解码缓存
-    struct {
-        uint32_t group_id;
-        uint8_t  shards[FEC_XOR_GROUP_SIZE + 1][FEC_SHARD_SIZE];
-        bool     present[FEC_XOR_GROUP_SIZE + 1];
-        size_t   shard_len;
-        uint64_t create_time;
-    } decode_cache[32];
-    int cache_count;
 } xor_fec_t;
 
-static int xor_encode(xor_fec_t *ctx,
-                      const uint8_t *data, size_t len,
-                      uint8_t out[][FEC_SHARD_SIZE],
-                      size_t out_lens[],
-                      uint32_t *group_id) {
-    uint8_t gs = ctx->group_size;
-    *group_id = ctx->next_group_id++;
-    
+static void xor_write_header(uint8_t *h, uint32_t group_id, uint8_t shard_idx,
+                             uint8_t gs, size_t shard_size, size_t payload_len) {
+    hdr_write_common(h, group_id, shard_idx, true);
+    h[5] = gs;
+    h[6] = (shard_size >> 8) & 0xFF;
+    h[7] = shard_size & 0xFF;
+    h[8] = (payload_len >> 8) & 0xFF;
+    h[9] = payload_len & 0xFF;
+}
+
+// 编码一组（gs 个数据分片 + 1 个校验），不修改任何状态
+static int xor_encode_group(uint8_t gs, uint32_t group_id,
+                            const uint8_t *data, size_t len,
+                            uint8_t out[][FEC_SHARD_SIZE],
+                            size_t out_lens[],
+                            bool unpadded) {
     // 分割数据
     size_t shard_size = (len + gs - 1) / gs;
-    if (shard_size > FEC_SHARD_SIZE - 8) shard_size = FEC_SHARD_SIZE - 8;
+    if (shard_size > FEC_SHARD_SIZE - FEC_HEADER_SIZE) shard_size = FEC_SHARD_SIZE - FEC_HEADER_SIZE;
+    if (len > gs * shard_size) len = gs * shard_size;
     
-    // Header: group_id(4) + shard_idx(1) + group_size(1) + shard_len(2)
     for (int i = 0; i < gs; i++) {
-        out[i][0] = (*group_id >> 24) & 0xFF;
-        out[i][1] = (*group_id >> 16) & 0xFF;
-        out[i][2] = (*group_id >> 8) & 0xFF;
-        out[i][3] = *group_id & 0xFF;
-        out[i][4] = i;
-        out[i][5] = gs;
-        out[i][6] = (shard_size >> 8) & 0xFF;
-        out[i][7] = shard_size & 0xFF;
+        xor_write_header(out[i], group_id, i, gs, shard_size, len);
         
         size_t offset = i * shard_size;
-        size_t copy_len = (offset + shard_size <= len) ? shard_size : 
-                          (offset < len ? len - offset : 0);
+        size_t copy_len = shard_data_len(len, shard_size, i);
         if (copy_len > 0) {
-            memcpy(out[i] + 8, data + offset, copy_len);
+            memcpy(out[i] + FEC_HEADER_SIZE, data + offset, copy_len);
         }
         if (copy_len < shard_size) {
-            memset(out[i] + 8 + copy_len, 0, shard_size - copy_len);
+            memset(out[i] + FEC_HEADER_SIZE + copy_len, 0, shard_size - copy_len);
         }
-        out_lens[i] = shard_size + 8;
+        out_lens[i] = (unpadded ? copy_len : shard_size) + FEC_HEADER_SIZE;
     }
     
     // XOR 校验分片
-    out[gs][0] = (*group_id >> 24) & 0xFF;
-    out[gs][1] = (*group_id >> 16) & 0xFF;
-    out[gs][2] = (*group_id >> 8) & 0xFF;
-    out[gs][3] = *group_id & 0xFF;
-    out[gs][4] = gs;  // parity shard index
-    out[gs][5] = gs;
-    out[gs][6] = (shard_size >> 8) & 0xFF;
-    out[gs][7] = shard_size & 0xFF;
+    xor_write_header(out[gs], group_id, gs, gs, shard_size, len);
     
     // XOR 所有数据分片
-    memset(out[gs] + 8, 0, shard_size);
-    for (int i = 0; i < gs; i++) {
-        for (size_t j = 0; j < shard_size; j++) {
-            out[gs][8 + j] ^= out[i][8 + j];
-        }
+    memcpy(out[gs] + FEC_HEADER_SIZE, out[0] + FEC_HEADER_SIZE, shard_size);
+    for (int i = 1; i < gs; i++) {
+        xor_region(out[gs] + FEC_HEADER_SIZE, out[i] + FEC_HEADER_SIZE, shard_size);
     }
-    out_lens[gs] = shard_size + 8;
+    out_lens[gs] = shard_size + FEC_HEADER_SIZE;
     
     return gs + 1;
 }
 
-static int xor_decode(xor_fec_t *ctx,
+static int xor_encode(xor_fec_t *ctx,
+                      const uint8_t *data, size_t len,
+                      uint8_t out[][FEC_SHARD_SIZE],
+                      size_t out_lens[],
+                      uint32_t *group_id,
+                      bool unpadded) {
+    *group_id = ctx->next_group_id++;
+    return xor_encode_group(ctx->group_size, *group_id, data, len, out, out_lens, unpadded);
+}
+
+// 系统码模式下的交付回调
+typedef struct {
+    fec_deliver_fn fn;
+    void          *user;
+} fec_deliver_t;
+
+static int xor_decode(fec_slot_table_t *tbl,
+                      const fec_deliver_t *deliver,
                       uint32_t group_id,
                       uint8_t shard_idx,
                       const uint8_t *data, size_t len,
                       uint8_t *out_data, size_t *out_len) {
-    if (len < 8) return -1;
+    if (!hdr_valid(data, len)) return -1;
     
     uint8_t gs = data[5];
     size_t shard_size = (data[6] << 8) | data[7];
-    
-    // 查找或创建缓存
-    int cache_idx = -1;
-    for (int i = 0; i < ctx->cache_count; i++) {
-        if (ctx->decode_cache[i].group_id == group_id) {
-            cache_idx = i;
-            break;
-        }
-    }
-    
-    if (cache_idx < 0) {
-        if (ctx->cache_count >= 32) {
-            // 淘汰最旧的
-            memmove(&ctx->decode_cache[0], &ctx->decode_cache[1], 
-                    31 * sizeof(ctx->decode_cache[0]));
-            ctx->cache_count = 31;
-        }
-        cache_idx = ctx->cache_count++;
-        memset(&ctx->decode_cache[cache_idx], 0, sizeof(ctx->decode_cache[0]));
-        ctx->decode_cache[cache_idx].group_id = group_id;
-        ctx->decode_cache[cache_idx].shard_len = shard_size;
+    size_t payload_len = (data[8] << 8) | data[9];
+    if (gs == 0 || gs + 1u > tbl->max_shards || shard_idx > gs) return -1;
+    if (shard_size > FEC_SHARD_SIZE - FEC_HEADER_SIZE || payload_len > gs * shard_size) return -1;
+    
+    // 数据分片可以不补齐，校验分片必须完整
+    size_t n = len - FEC_HEADER_SIZE;
+    if (n > shard_size) n = shard_size;
+    if (n < (shard_idx < gs ? shard_data_len(payload_len, shard_size, shard_idx) : shard_size)) {
+        return -1;
     }
     
-    // 保存分片
-    if (shard_idx <= gs) {
-        memcpy(ctx->decode_cache[cache_idx].shards[shard_idx], data + 8, shard_size);
-        ctx->decode_cache[cache_idx].present[shard_idx] = true;
-    }
+    // 已完成组的迟到分片
+    if (slot_is_late(tbl, group_id)) return 0;
     
-    // 检查是否能恢复
-    int present_count = 0;
-    int missing_idx = -1;
-    for (int i = 0; i <= gs; i++) {
-        if (ctx->decode_cache[cache_idx].present[i]) {
-            present_count++;
-        } else {
-            missing_idx = i;
-        }
+    // 查找或创建缓存
+    fec_slot_t *slot = slot_acquire(tbl, group_id);
+    if (slot_prepare(tbl, slot, gs, 1, shard_size) < 0) return -1;
+    if (slot->present_count == 0) slot->payload_len = payload_len;
+    
+    // 保存分片，系统码模式下数据分片立即交付（只交付有效长度）
+    bool fresh = !slot->present[shard_idx];
+    int present_count = slot_store(slot, shard_idx, data + FEC_HEADER_SIZE, n);
+    size_t dlen = shard_data_len(payload_len, shard_size, shard_idx);
+    if (deliver->fn && fresh && shard_idx < gs && dlen > 0) {
+        deliver->fn(deliver->user, group_id, shard_idx, data + FEC_HEADER_SIZE, dlen);
     }
     
     // XOR FEC 只能恢复 1 个丢失
@@ -203,529 +678,2835 @@ static int xor_decode(xor_fec_t *ctx,
         return 0;  // 继续等待
     }
     
-    if (present_count == gs && missing_idx >= 0 && missing_idx < gs) {
+    int missing_idx = -1;
+    for (int i = 0; i < gs; i++) {
+        if (!slot->present[i]) missing_idx = i;
+    }
+    
+    if (missing_idx >= 0) {
         // 恢复丢失的数据分片
-        memset(ctx->decode_cache[cache_idx].shards[missing_idx], 0, shard_size);
+        uint8_t *dst = slot_shard(slot, missing_idx);
+        memset(dst, 0, shard_size);
         for (int i = 0; i <= gs; i++) {
-            if (i != missing_idx && ctx->decode_cache[cache_idx].present[i]) {
-                for (size_t j = 0; j < shard_size; j++) {
-                    ctx->decode_cache[cache_idx].shards[missing_idx][j] ^= 
-                        ctx->decode_cache[cache_idx].shards[i][j];
-                }
+            if (i != missing_idx && slot->present[i]) {
+                xor_region(dst, slot_shard(slot, i), shard_size);
             }
         }
-        ctx->decode_cache[cache_idx].present[missing_idx] = true;
+        slot->present[missing_idx] = true;
+        slot->recovered = true;
+        size_t mlen = shard_data_len(payload_len, shard_size, missing_idx);
+        if (deliver->fn && mlen > 0) {
+            deliver->fn(deliver->user, group_id, missing_idx, dst, mlen);
+        }
     }
     
-    // 拼接数据
-    *out_len = 0;
-    for (int i = 0; i < gs; i++) {
-        memcpy(out_data + *out_len, ctx->decode_cache[cache_idx].shards[i], shard_size);
-        *out_len += shard_size;
+    // 拼接数据，按精确负载长度截去补齐
+    if (!deliver->fn) {
+        *out_len = 0;
+        for (int i = 0; i < gs; i++) {
+            size_t l = shard_data_len(payload_len, shard_size, i);
+            memcpy(out_data + *out_len, slot_shard(slot, i), l);
+            *out_len += l;
+        }
     }
     
     // 清理缓存
-    ctx->decode_cache[cache_idx].group_id = 0;
+    slot_complete(tbl, slot);
     
     return 1;
 }
 
 // =========================================================
-// RS SIMD 实现
+// 二维 XOR（行 + 列校验）
 // =========================================================
-#ifdef HAVE_AVX2
+// 每次 fec_encode 编码一个源包。源包按行排成 D 行 x L 列的块：
+// 每满一行发一个行校验（行内任意 1 个丢失可恢复），每满一块再发 L 个
+// 列校验（同一列的 D 个包中任意 1 个丢失可恢复）。按发送顺序连续丢失
+// 的一串包落在不同列上，整行丢失（突发不超过 L + 1 个包）也能由列校验
+// 恢复；行列交替剥离还能恢复更多组合。全部是区域异或，无 GF 乘法
+//
+// 与滑动窗口相同，源符号 = 2 字节长度 + 负载，校验长度取参与的最长符号，
+// 恢复后由长度前缀还原负载长度
+//
+// 块内分片编号：数据 r * L + c，行校验 L * D + r，列校验 L * D + D + c
+// 分片头：公共部分 + L + D
+#define X2D_SYMBOL      (FEC_SHARD_SIZE - FEC_HEADER_SIZE)
 
-// AVX2 加速的 GF 乘法（一次处理 32 字节）
-static inline __m256i gf_mul_avx2(__m256i a, uint8_t b) {
-    if (b == 0) return _mm256_setzero_si256();
-    if (b == 1) return a;
-    
-    __m256i result = _mm256_setzero_si256();
-    __m256i log_b = _mm256_set1_epi8(gf_log[b]);
-    
-    // 对每个字节进行 GF 乘法
-    // 这里使用查表法的 SIMD 版本
-    uint8_t temp_a[32], temp_r[32];
-    _mm256_storeu_si256((__m256i*)temp_a, a);
+typedef struct {
+    uint8_t  width;             // L
+    uint8_t  depth;             // D
+    uint32_t next_block;
+    int      pos;               // 块内下一个源包位置
+    uint16_t row_len;
+    uint16_t col_len[FEC_XOR2D_MAX_WIDTH];
+    uint8_t  row_acc[X2D_SYMBOL];
+    uint8_t  col_acc[FEC_XOR2D_MAX_WIDTH][X2D_SYMBOL];
+} xor2d_ctx_t;
+
+static inline int x2d_total(int width, int depth) {
+    return width * depth + width + depth;
+}
+
+static void x2d_write_header(uint8_t *h, uint32_t block, uint8_t idx,
+                             uint8_t width, uint8_t depth) {
+    hdr_write_common(h, block, idx, false);
+    h[5] = width;
+    h[6] = depth;
+    h[7] = 0;
+    h[8] = 0;
+    h[9] = 0;
+}
+
+// 累加一个符号（长度前缀 + 负载），acc 超出 *acc_len 的部分保持为 0
+static inline void x2d_accumulate(uint8_t *acc, uint16_t *acc_len,
+                                  const uint8_t *data, size_t len) {
+    acc[0] ^= (len >> 8) & 0xFF;
+    acc[1] ^= len & 0xFF;
+    xor_region(acc + 2, data, len);
+    if (len + 2 > *acc_len) *acc_len = len + 2;
+}
+
+static int x2d_encode(xor2d_ctx_t *x,
+                      const uint8_t *data, size_t len,
+                      uint8_t out_shards[][FEC_SHARD_SIZE],
+                      size_t out_lens[],
+                      uint32_t *group_id) {
+    if (len > FEC_XOR2D_MAX_PAYLOAD) return -1;
+    
+    int L = x->width, D = x->depth;
+    int r = x->pos / L, c = x->pos % L;
+    *group_id = x->next_block;
+    
+    x2d_write_header(out_shards[0], x->next_block, x->pos, L, D);
+    memcpy(out_shards[0] + FEC_HEADER_SIZE, data, len);
+    out_lens[0] = len + FEC_HEADER_SIZE;
+    int n = 1;
+    
+    x2d_accumulate(x->row_acc, &x->row_len, data, len);
+    x2d_accumulate(x->col_acc[c], &x->col_len[c], data, len);
+    x->pos++;
+    
+    // 行满：发行校验
+    if (c == L - 1) {
+        x2d_write_header(out_shards[n], x->next_block, L * D + r, L, D);
+        memcpy(out_shards[n] + FEC_HEADER_SIZE, x->row_acc, x->row_len);
+        out_lens[n++] = x->row_len + FEC_HEADER_SIZE;
+        memset(x->row_acc, 0, x->row_len);
+        x->row_len = 0;
+    }
     
-    for (int i = 0; i < 32; i++) {
-        temp_r[i] = gf_mul_table[temp_a[i]][b];
+    // 块满：发列校验，开始下一块
+    if (x->pos == L * D) {
+        for (int j = 0; j < L; j++) {
+            x2d_write_header(out_shards[n], x->next_block, L * D + D + j, L, D);
+            memcpy(out_shards[n] + FEC_HEADER_SIZE, x->col_acc[j], x->col_len[j]);
+            out_lens[n++] = x->col_len[j] + FEC_HEADER_SIZE;
+            memset(x->col_acc[j], 0, x->col_len[j]);
+            x->col_len[j] = 0;
+        }
+        x->pos = 0;
+        x->next_block++;
     }
     
-    return _mm256_loadu_si256((__m256i*)temp_r);
+    return n;
 }
 
-static void rs_encode_avx2(const uint8_t data[][FEC_SHARD_SIZE],
-                           int data_count,
-                           uint8_t parity[][FEC_SHARD_SIZE],
-                           int parity_count,
-                           int shard_size) {
-    gf_init();
-    
-    // 生成 Vandermonde 矩阵行
-    uint8_t matrix[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
-    for (int p = 0; p < parity_count; p++) {
-        uint8_t x = data_count + p + 1;
-        matrix[p][0] = 1;
-        for (int j = 1; j < data_count; j++) {
-            matrix[p][j] = gf_mul_table[matrix[p][j-1]][x];
+// members 中恰好缺 1 个数据分片时，用其余分片异或恢复它；返回恢复的编号，否则 -1
+static int x2d_recover(fec_slot_t *s, const int *members, int count, int data_count) {
+    int missing = -1;
+    for (int k = 0; k < count; k++) {
+        if (!s->present[members[k]]) {
+            if (missing >= 0) return -1;
+            missing = members[k];
         }
     }
+    if (missing < 0 || missing >= data_count) return -1;
     
-    // 使用 AVX2 计算 parity
-    for (int p = 0; p < parity_count; p++) {
-        memset(parity[p], 0, shard_size);
-        
-        for (int d = 0; d < data_count; d++) {
-            uint8_t coef = matrix[p][d];
-            if (coef == 0) continue;
-            
-            int i = 0;
-            // AVX2 处理（32 字节一组）
-            for (; i + 32 <= shard_size; i += 32) {
-                __m256i src = _mm256_loadu_si256((__m256i*)(data[d] + i));
-                __m256i dst = _mm256_loadu_si256((__m256i*)(parity[p] + i));
-                __m256i mul = gf_mul_avx2(src, coef);
-                dst = _mm256_xor_si256(dst, mul);
-                _mm256_storeu_si256((__m256i*)(parity[p] + i), dst);
-            }
-            // 处理剩余
-            for (; i < shard_size; i++) {
-                parity[p][i] ^= gf_mul_table[data[d][i]][coef];
-            }
-        }
+    uint16_t len = 0;
+    for (int k = 0; k < count; k++) {
+        if (members[k] != missing && s->lens[members[k]] > len) len = s->lens[members[k]];
+    }
+    
+    uint8_t *dst = slot_shard(s, missing);
+    memset(dst, 0, len);
+    for (int k = 0; k < count; k++) {
+        if (members[k] != missing) xor_region(dst, slot_shard(s, members[k]), s->lens[members[k]]);
     }
+    
+    size_t plen = (dst[0] << 8) | dst[1];
+    if (len < 2 || plen > (size_t)len - 2) return -1;
+    
+    s->lens[missing] = plen + 2;
+    s->present[missing] = true;
+    s->recovered = true;
+    s->present_count++;
+    s->data_present++;
+    return missing;
 }
 
-#endif // HAVE_AVX2
-
-#ifdef HAVE_NEON
-
-// NEON 加速版本
-static void rs_encode_neon(const uint8_t data[][FEC_SHARD_SIZE],
-                           int data_count,
-                           uint8_t parity[][FEC_SHARD_SIZE],
-                           int parity_count,
-                           int shard_size) {
-    gf_init();
+static int x2d_decode(fec_slot_table_t *tbl, const fec_deliver_t *deliver,
+                      uint32_t group_id, uint8_t shard_idx,
+                      const uint8_t *shard, size_t shard_len,
+                      uint8_t *out_data, size_t *out_len) {
+    int L = shard[5], D = shard[6];
+    if (L < 2 || L > FEC_XOR2D_MAX_WIDTH || D < 1 ||
+        x2d_total(L, D) > (int)tbl->max_shards || shard_idx >= x2d_total(L, D)) return -1;
+    
+    const uint8_t *payload = shard + FEC_HEADER_SIZE;
+    size_t len = shard_len - FEC_HEADER_SIZE;
+    int data_count = L * D;
+    bool is_data = shard_idx < data_count;
+    if (len > (is_data ? FEC_XOR2D_MAX_PAYLOAD : X2D_SYMBOL)) return -1;
+    
+    if (slot_is_late(tbl, group_id)) return 0;
+    
+    fec_slot_t *slot = slot_acquire(tbl, group_id);
+    if (slot_prepare(tbl, slot, data_count, L + D, X2D_SYMBOL) < 0) return -1;
+    if (slot->present[shard_idx]) return 0;
+    
+    // 数据分片存为符号形式（长度前缀 + 负载），与校验统一做异或
+    uint8_t *dst = slot_shard(slot, shard_idx);
+    if (is_data) {
+        dst[0] = (len >> 8) & 0xFF;
+        dst[1] = len & 0xFF;
+        memcpy(dst + 2, payload, len);
+        slot->lens[shard_idx] = len + 2;
+        slot->data_present++;
+    } else {
+        memcpy(dst, payload, len);
+        slot->lens[shard_idx] = len;
+    }
+    slot->present[shard_idx] = true;
+    slot->present_count++;
     
-    uint8_t matrix[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
-    for (int p = 0; p < parity_count; p++) {
-        uint8_t x = data_count + p + 1;
-        matrix[p][0] = 1;
-        for (int j = 1; j < data_count; j++) {
-            matrix[p][j] = gf_mul_table[matrix[p][j-1]][x];
+    int ret = 0;
+    if (is_data) {
+        if (deliver->fn) {
+            deliver->fn(deliver->user, group_id, shard_idx, payload, len);
+        } else {
+            memcpy(out_data, payload, len);
+            *out_len = len;
         }
+        ret = 1;
     }
     
-    for (int p = 0; p < parity_count; p++) {
-        memset(parity[p], 0, shard_size);
+    // 行列交替剥离，直到没有只缺 1 个的行或列
+    int members[FEC_XOR2D_MAX_WIDTH + FEC_MAX_TOTAL_SHARDS];
+    bool progress = true;
+    while (progress && slot->data_present < data_count) {
+        progress = false;
         
-        for (int d = 0; d < data_count; d++) {
-            uint8_t coef = matrix[p][d];
-            if (coef == 0) continue;
+        for (int r = 0; r < D; r++) {
+            int n = 0;
+            for (int c = 0; c < L; c++) members[n++] = r * L + c;
+            members[n++] = data_count + r;
             
-            int i = 0;
-            // NEON 处理（16 字节一组）
-            for (; i + 16 <= shard_size; i += 16) {
-                uint8x16_t src = vld1q_u8(data[d] + i);
-                uint8x16_t dst = vld1q_u8(parity[p] + i);
-                
-                // NEON GF 乘法（使用查表）
-                uint8_t temp_src[16], temp_mul[16];
-                vst1q_u8(temp_src, src);
-                for (int k = 0; k < 16; k++) {
-                    temp_mul[k] = gf_mul_table[temp_src[k]][coef];
+            int got = x2d_recover(slot, members, n, data_count);
+            if (got >= 0) {
+                if (deliver->fn) {
+                    deliver->fn(deliver->user, group_id, got,
+                                slot_shard(slot, got) + 2, slot->lens[got] - 2);
                 }
-                uint8x16_t mul = vld1q_u8(temp_mul);
-                
-                dst = veorq_u8(dst, mul);
-                vst1q_u8(parity[p] + i, dst);
+                progress = true;
+                ret = 1;
             }
-            for (; i < shard_size; i++) {
-                parity[p][i] ^= gf_mul_table[data[d][i]][coef];
+        }
+        
+        for (int c = 0; c < L; c++) {
+            int n = 0;
+            for (int r = 0; r < D; r++) members[n++] = r * L + c;
+            members[n++] = data_count + D + c;
+            
+            int got = x2d_recover(slot, members, n, data_count);
+            if (got >= 0) {
+                if (deliver->fn) {
+                    deliver->fn(deliver->user, group_id, got,
+                                slot_shard(slot, got) + 2, slot->lens[got] - 2);
+                }
+                progress = true;
+                ret = 1;
             }
         }
     }
+    
+    // 全部数据已交付：标记完成，迟到的校验直接丢弃
+    if (slot->data_present == data_count) slot_complete(tbl, slot);
+    
+    return ret;
 }
 
-#endif // HAVE_NEON
-
 // =========================================================
-// RS 简单实现（无 SIMD）
+// RS 编码矩阵
 // =========================================================
-static void rs_encode_simple(const uint8_t data[][FEC_SHARD_SIZE],
-                             int data_count,
-                             uint8_t parity[][FEC_SHARD_SIZE],
-                             int parity_count,
-                             int shard_size) {
-    gf_init();
-    
-    uint8_t matrix[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
-    for (int p = 0; p < parity_count; p++) {
-        uint8_t x = data_count + p + 1;
-        matrix[p][0] = 1;
-        for (int j = 1; j < data_count; j++) {
-            matrix[p][j] = gf_mul_table[matrix[p][j-1]][x];
-        }
-    }
-    
+// 系统码：数据分片原样发送，校验行取 Cauchy 矩阵
+//   parity[p][j] = 1 / ((ds + p) ^ j)
+// Cauchy 矩阵任意方阵子式非奇异，任意 ds 个分片都能恢复
+static void rs_matrix_build(uint8_t matrix[][FEC_MAX_DATA_SHARDS],
+                            int data_count, int parity_count) {
     for (int p = 0; p < parity_count; p++) {
-        memset(parity[p], 0, shard_size);
-        for (int byte = 0; byte < shard_size; byte++) {
-            for (int d = 0; d < data_count; d++) {
-                parity[p][byte] ^= gf_mul_table[data[d][byte]][matrix[p][d]];
-            }
+        for (int j = 0; j < data_count; j++) {
+            uint8_t x = (uint8_t)((data_count + p) ^ j);
+            matrix[p][j] = gf_exp[255 - gf_log[x]];
         }
     }
 }
 
 // =========================================================
-// RS 解码（高斯消元）
+// RS SIMD 实现
 // =========================================================
-static int rs_decode_common(uint8_t shards[][FEC_SHARD_SIZE],
-                            bool *present,
-                            int data_count,
-                            int total_count,
-                            int shard_size) {
-    gf_init();
-    
-    int available = 0;
-    for (int i = 0; i < total_count; i++) {
-        if (present[i]) available++;
-    }
-    if (available < data_count) return -1;
-    
-    // 构建矩阵
-    uint8_t matrix[FEC_MAX_DATA_SHARDS][FEC_MAX_DATA_SHARDS];
-    uint8_t *shard_ptrs[FEC_MAX_DATA_SHARDS];
-    
-    int idx = 0;
-    for (int i = 0; i < total_count && idx < data_count; i++) {
-        if (present[i]) {
-            // Vandermonde 行
-            uint8_t x = i + 1;
-            matrix[idx][0] = 1;
-            for (int j = 1; j < data_count; j++) {
-                matrix[idx][j] = gf_mul_table[matrix[idx][j-1]][x];
-            }
-            shard_ptrs[idx] = shards[i];
-            idx++;
-        }
+// 区域乘加内核：dst ^= c * src
+// 每种指令集一个实现，fec_create() 时按 CPU 特性选定
+typedef void (*gf_mul_xor_fn)(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len);
+
+// 分块编码内核：按列块遍历，每块数据只读一次，同时累加所有校验行
+// 返回已处理的字节数（向量宽度的整数倍），剩余尾部由调用方用 mul_xor 补完
+typedef int (*gf_encode_fn)(const uint8_t *const data[], int data_count,
+                            uint8_t *const parity[], int parity_count, int len,
+                            const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]);
+
+typedef struct {
+    const char    *name;
+    gf_mul_xor_fn  mul_xor;
+    gf_encode_fn   encode;      // NULL = 用 mul_xor 按条带分块
+    uint32_t       features;    // 所需 CPU_FEATURE_* 位
+} fec_kernel_t;
+
+// 每个列块把校验行按 4 行一组累加；组内行数为编译期常量，
+// 累加器可完全展开到寄存器（AVX2 16 个 ymm 足够 4 行 + 查表临时量）
+#define FEC_ENCODE_ROWS     4
+
+#define FEC_ENCODE_ROW_GROUPS(rows_fn, data, dc, parity, pc, i, coef)       \
+    for (int p_ = 0; p_ < (pc); p_ += FEC_ENCODE_ROWS) {                    \
+        switch ((pc) - p_) {                                                \
+        case 1:  rows_fn(data, dc, (parity) + p_, 1, i, (coef) + p_); break; \
+        case 2:  rows_fn(data, dc, (parity) + p_, 2, i, (coef) + p_); break; \
+        case 3:  rows_fn(data, dc, (parity) + p_, 3, i, (coef) + p_); break; \
+        default: rows_fn(data, dc, (parity) + p_, 4, i, (coef) + p_); break; \
+        }                                                                   \
+    }
+
+#ifdef HAVE_AVX2
+
+// 各内核用 target 属性单独编译，同一个二进制可在老 CPU 上安全回退
+
+// AVX2 加速的 GF 乘法（一次处理 32 字节）
+// 拆分高低半字节，各用一次 PSHUFB 查 16 项表，再异或合并
+__attribute__((target("avx2")))
+static inline __m256i gf_mul_avx2(__m256i a, __m256i tlo, __m256i thi, __m256i mask) {
+    __m256i lo = _mm256_and_si256(a, mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi64(a, 4), mask);
+    return _mm256_xor_si256(_mm256_shuffle_epi8(tlo, lo),
+                            _mm256_shuffle_epi8(thi, hi));
+}
+
+__attribute__((target("avx2")))
+static void gf_mul_xor_avx2(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len) {
+    if (c->c == 0) return;
+    
+    __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)c->lo));
+    __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)c->hi));
+    __m256i mask = _mm256_set1_epi8(0x0F);
+    
+    int i = 0;
+    // 64 字节展开，隐藏 PSHUFB 延迟
+    for (; i + 64 <= len; i += 64) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i s1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        __m256i d0 = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i d1 = _mm256_loadu_si256((const __m256i*)(dst + i + 32));
+        d0 = _mm256_xor_si256(d0, gf_mul_avx2(s0, tlo, thi, mask));
+        d1 = _mm256_xor_si256(d1, gf_mul_avx2(s1, tlo, thi, mask));
+        _mm256_storeu_si256((__m256i*)(dst + i), d0);
+        _mm256_storeu_si256((__m256i*)(dst + i + 32), d1);
+    }
+    for (; i + 32 <= len; i += 32) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d0 = _mm256_loadu_si256((const __m256i*)(dst + i));
+        d0 = _mm256_xor_si256(d0, gf_mul_avx2(s0, tlo, thi, mask));
+        _mm256_storeu_si256((__m256i*)(dst + i), d0);
+    }
+    // 处理剩余
+    for (; i < len; i++) {
+        dst[i] ^= gf_mul_table[c->c][src[i]];
+    }
+}
+
+// GFNI + AVX2：一条 vgf2p8affineqb 完成 32 字节乘法
+__attribute__((target("avx2,gfni")))
+static void gf_mul_xor_gfni_avx2(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len) {
+    if (c->c == 0) return;
+    
+    __m256i m = _mm256_set1_epi64x((long long)c->affine);
+    
+    int i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i s1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        __m256i d0 = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i d1 = _mm256_loadu_si256((const __m256i*)(dst + i + 32));
+        d0 = _mm256_xor_si256(d0, _mm256_gf2p8affine_epi64_epi8(s0, m, 0));
+        d1 = _mm256_xor_si256(d1, _mm256_gf2p8affine_epi64_epi8(s1, m, 0));
+        _mm256_storeu_si256((__m256i*)(dst + i), d0);
+        _mm256_storeu_si256((__m256i*)(dst + i + 32), d1);
+    }
+    for (; i + 32 <= len; i += 32) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d0 = _mm256_loadu_si256((const __m256i*)(dst + i));
+        d0 = _mm256_xor_si256(d0, _mm256_gf2p8affine_epi64_epi8(s0, m, 0));
+        _mm256_storeu_si256((__m256i*)(dst + i), d0);
+    }
+    for (; i < len; i++) {
+        dst[i] ^= gf_mul_table[c->c][src[i]];
+    }
+}
+
+// AVX-512BW：64 字节 PSHUFB，尾部用字节掩码读写，无需标量收尾
+__attribute__((target("avx512f,avx512bw")))
+static void gf_mul_xor_avx512(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len) {
+    if (c->c == 0) return;
+    
+    __m512i tlo = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)c->lo));
+    __m512i thi = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)c->hi));
+    __m512i mask = _mm512_set1_epi8(0x0F);
+    
+    int i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m512i s = _mm512_loadu_si512(src + i);
+        __m512i d = _mm512_loadu_si512(dst + i);
+        __m512i lo = _mm512_and_si512(s, mask);
+        __m512i hi = _mm512_and_si512(_mm512_srli_epi64(s, 4), mask);
+        d = _mm512_xor_si512(d, _mm512_xor_si512(_mm512_shuffle_epi8(tlo, lo),
+                                                 _mm512_shuffle_epi8(thi, hi)));
+        _mm512_storeu_si512(dst + i, d);
+    }
+    if (i < len) {
+        __mmask64 k = ~0ULL >> (64 - (len - i));
+        __m512i s = _mm512_maskz_loadu_epi8(k, src + i);
+        __m512i d = _mm512_maskz_loadu_epi8(k, dst + i);
+        __m512i lo = _mm512_and_si512(s, mask);
+        __m512i hi = _mm512_and_si512(_mm512_srli_epi64(s, 4), mask);
+        d = _mm512_xor_si512(d, _mm512_xor_si512(_mm512_shuffle_epi8(tlo, lo),
+                                                 _mm512_shuffle_epi8(thi, hi)));
+        _mm512_mask_storeu_epi8(dst + i, k, d);
+    }
+}
+
+// GFNI + AVX-512：Ice Lake / Zen4 上的最快路径
+__attribute__((target("avx512f,avx512bw,gfni")))
+static void gf_mul_xor_gfni_avx512(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len) {
+    if (c->c == 0) return;
+    
+    __m512i m = _mm512_set1_epi64((long long)c->affine);
+    
+    int i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m512i s = _mm512_loadu_si512(src + i);
+        __m512i d = _mm512_loadu_si512(dst + i);
+        d = _mm512_xor_si512(d, _mm512_gf2p8affine_epi64_epi8(s, m, 0));
+        _mm512_storeu_si512(dst + i, d);
+    }
+    if (i < len) {
+        __mmask64 k = ~0ULL >> (64 - (len - i));
+        __m512i s = _mm512_maskz_loadu_epi8(k, src + i);
+        __m512i d = _mm512_maskz_loadu_epi8(k, dst + i);
+        d = _mm512_xor_si512(d, _mm512_gf2p8affine_epi64_epi8(s, m, 0));
+        _mm512_mask_storeu_epi8(dst + i, k, d);
+    }
+}
+
+// ---------------------------------------------------------
+// 分块编码：数据列块加载一次、拆半字节一次，供 np 行校验共用
+// ---------------------------------------------------------
+__attribute__((target("avx2"), always_inline))
+static inline void gf_encode_rows_avx2(const uint8_t *const data[], int dc,
+                                       uint8_t *const parity[], int np, int i,
+                                       const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i acc[FEC_ENCODE_ROWS];
+    for (int p = 0; p < np; p++) acc[p] = _mm256_setzero_si256();
+    
+    for (int d = 0; d < dc; d++) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(data[d] + i));
+        __m256i lo = _mm256_and_si256(s, mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi64(s, 4), mask);
+        for (int p = 0; p < np; p++) {
+            __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)coef[p][d].lo));
+            __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)coef[p][d].hi));
+            acc[p] = _mm256_xor_si256(acc[p], _mm256_xor_si256(_mm256_shuffle_epi8(tlo, lo),
+                                                               _mm256_shuffle_epi8(thi, hi)));
+        }
+    }
+    
+    for (int p = 0; p < np; p++) {
+        _mm256_storeu_si256((__m256i*)(parity[p] + i), acc[p]);
+    }
+}
+
+__attribute__((target("avx2")))
+static int gf_encode_avx2(const uint8_t *const data[], int dc,
+                          uint8_t *const parity[], int pc, int len,
+                          const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    int n = len & ~31;
+    for (int i = 0; i < n; i += 32) {
+        FEC_ENCODE_ROW_GROUPS(gf_encode_rows_avx2, data, dc, parity, pc, i, coef);
+    }
+    return n;
+}
+
+__attribute__((target("avx2,gfni"), always_inline))
+static inline void gf_encode_rows_gfni_avx2(const uint8_t *const data[], int dc,
+                                            uint8_t *const parity[], int np, int i,
+                                            const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    __m256i acc[FEC_ENCODE_ROWS];
+    for (int p = 0; p < np; p++) acc[p] = _mm256_setzero_si256();
+    
+    for (int d = 0; d < dc; d++) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(data[d] + i));
+        for (int p = 0; p < np; p++) {
+            __m256i m = _mm256_set1_epi64x((long long)coef[p][d].affine);
+            acc[p] = _mm256_xor_si256(acc[p], _mm256_gf2p8affine_epi64_epi8(s, m, 0));
+        }
+    }
+    
+    for (int p = 0; p < np; p++) {
+        _mm256_storeu_si256((__m256i*)(parity[p] + i), acc[p]);
+    }
+}
+
+__attribute__((target("avx2,gfni")))
+static int gf_encode_gfni_avx2(const uint8_t *const data[], int dc,
+                               uint8_t *const parity[], int pc, int len,
+                               const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    int n = len & ~31;
+    for (int i = 0; i < n; i += 32) {
+        FEC_ENCODE_ROW_GROUPS(gf_encode_rows_gfni_avx2, data, dc, parity, pc, i, coef);
+    }
+    return n;
+}
+
+__attribute__((target("avx512f,avx512bw"), always_inline))
+static inline void gf_encode_rows_avx512(const uint8_t *const data[], int dc,
+                                         uint8_t *const parity[], int np, int i,
+                                         const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    __m512i mask = _mm512_set1_epi8(0x0F);
+    __m512i acc[FEC_ENCODE_ROWS];
+    for (int p = 0; p < np; p++) acc[p] = _mm512_setzero_si512();
+    
+    for (int d = 0; d < dc; d++) {
+        __m512i s = _mm512_loadu_si512(data[d] + i);
+        __m512i lo = _mm512_and_si512(s, mask);
+        __m512i hi = _mm512_and_si512(_mm512_srli_epi64(s, 4), mask);
+        for (int p = 0; p < np; p++) {
+            __m512i tlo = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)coef[p][d].lo));
+            __m512i thi = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)coef[p][d].hi));
+            acc[p] = _mm512_xor_si512(acc[p], _mm512_xor_si512(_mm512_shuffle_epi8(tlo, lo),
+                                                               _mm512_shuffle_epi8(thi, hi)));
+        }
+    }
+    
+    for (int p = 0; p < np; p++) {
+        _mm512_storeu_si512(parity[p] + i, acc[p]);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static int gf_encode_avx512(const uint8_t *const data[], int dc,
+                            uint8_t *const parity[], int pc, int len,
+                            const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    int n = len & ~63;
+    for (int i = 0; i < n; i += 64) {
+        FEC_ENCODE_ROW_GROUPS(gf_encode_rows_avx512, data, dc, parity, pc, i, coef);
+    }
+    return n;
+}
+
+__attribute__((target("avx512f,avx512bw,gfni"), always_inline))
+static inline void gf_encode_rows_gfni_avx512(const uint8_t *const data[], int dc,
+                                              uint8_t *const parity[], int np, int i,
+                                              const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    __m512i acc[FEC_ENCODE_ROWS];
+    for (int p = 0; p < np; p++) acc[p] = _mm512_setzero_si512();
+    
+    for (int d = 0; d < dc; d++) {
+        __m512i s = _mm512_loadu_si512(data[d] + i);
+        for (int p = 0; p < np; p++) {
+            __m512i m = _mm512_set1_epi64((long long)coef[p][d].affine);
+            acc[p] = _mm512_xor_si512(acc[p], _mm512_gf2p8affine_epi64_epi8(s, m, 0));
+        }
+    }
+    
+    for (int p = 0; p < np; p++) {
+        _mm512_storeu_si512(parity[p] + i, acc[p]);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw,gfni")))
+static int gf_encode_gfni_avx512(const uint8_t *const data[], int dc,
+                                 uint8_t *const parity[], int pc, int len,
+                                 const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    int n = len & ~63;
+    for (int i = 0; i < n; i += 64) {
+        FEC_ENCODE_ROW_GROUPS(gf_encode_rows_gfni_avx512, data, dc, parity, pc, i, coef);
+    }
+    return n;
+}
+
+#endif // HAVE_AVX2
+
+#ifdef HAVE_NEON
+
+// NEON 加速版本：vqtbl1q_u8 查半字节表，一次 16 字节
+static inline uint8x16_t gf_mul_neon(uint8x16_t a, uint8x16_t tlo, uint8x16_t thi,
+                                     uint8x16_t mask) {
+    return veorq_u8(vqtbl1q_u8(tlo, vandq_u8(a, mask)),
+                    vqtbl1q_u8(thi, vshrq_n_u8(a, 4)));
+}
+
+static void gf_mul_xor_neon(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len) {
+    if (c->c == 0) return;
+    
+    uint8x16_t tlo = vld1q_u8(c->lo);
+    uint8x16_t thi = vld1q_u8(c->hi);
+    uint8x16_t mask = vdupq_n_u8(0x0F);
+    
+    int i = 0;
+    // 32 字节展开，两条 TBL 链并行
+    for (; i + 32 <= len; i += 32) {
+        uint8x16_t s0 = vld1q_u8(src + i);
+        uint8x16_t s1 = vld1q_u8(src + i + 16);
+        uint8x16_t d0 = vld1q_u8(dst + i);
+        uint8x16_t d1 = vld1q_u8(dst + i + 16);
+        d0 = veorq_u8(d0, gf_mul_neon(s0, tlo, thi, mask));
+        d1 = veorq_u8(d1, gf_mul_neon(s1, tlo, thi, mask));
+        vst1q_u8(dst + i, d0);
+        vst1q_u8(dst + i + 16, d1);
+    }
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t s0 = vld1q_u8(src + i);
+        uint8x16_t d0 = vld1q_u8(dst + i);
+        vst1q_u8(dst + i, veorq_u8(d0, gf_mul_neon(s0, tlo, thi, mask)));
+    }
+    for (; i < len; i++) {
+        dst[i] ^= gf_mul_table[c->c][src[i]];
+    }
+}
+
+static inline __attribute__((always_inline))
+void gf_encode_rows_neon(const uint8_t *const data[], int dc,
+                         uint8_t *const parity[], int np, int i,
+                         const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    uint8x16_t mask = vdupq_n_u8(0x0F);
+    uint8x16_t acc[FEC_ENCODE_ROWS];
+    for (int p = 0; p < np; p++) acc[p] = vdupq_n_u8(0);
+    
+    for (int d = 0; d < dc; d++) {
+        uint8x16_t s = vld1q_u8(data[d] + i);
+        uint8x16_t lo = vandq_u8(s, mask);
+        uint8x16_t hi = vshrq_n_u8(s, 4);
+        for (int p = 0; p < np; p++) {
+            acc[p] = veorq_u8(acc[p], veorq_u8(vqtbl1q_u8(vld1q_u8(coef[p][d].lo), lo),
+                                               vqtbl1q_u8(vld1q_u8(coef[p][d].hi), hi)));
+        }
+    }
+    
+    for (int p = 0; p < np; p++) {
+        vst1q_u8(parity[p] + i, acc[p]);
+    }
+}
+
+static int gf_encode_neon(const uint8_t *const data[], int dc,
+                          uint8_t *const parity[], int pc, int len,
+                          const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    int n = len & ~15;
+    for (int i = 0; i < n; i += 16) {
+        FEC_ENCODE_ROW_GROUPS(gf_encode_rows_neon, data, dc, parity, pc, i, coef);
+    }
+    return n;
+}
+
+#endif // HAVE_NEON
+
+#ifdef HAVE_SVE
+
+// SVE 版本：与向量长度无关，谓词处理尾部
+// svld1rq 把 16 字节表复制到每个 128 位段，TBL 索引 0..15 在任意 VL 下都正确
+static void gf_mul_xor_sve(uint8_t *dst, const uint8_t *src, const gf_coef_t *c, int len) {
+    if (c->c == 0) return;
+    
+    svbool_t all = svptrue_b8();
+    svuint8_t tlo = svld1rq_u8(all, c->lo);
+    svuint8_t thi = svld1rq_u8(all, c->hi);
+    int step = (int)svcntb();
+    
+    for (int i = 0; i < len; i += step) {
+        svbool_t pg = svwhilelt_b8_s32(i, len);
+        svuint8_t s = svld1_u8(pg, src + i);
+        svuint8_t d = svld1_u8(pg, dst + i);
+        svuint8_t lo = svand_n_u8_x(pg, s, 0x0F);
+        svuint8_t hi = svlsr_n_u8_x(pg, s, 4);
+        svuint8_t m = sveor_u8_x(pg, svtbl_u8(tlo, lo), svtbl_u8(thi, hi));
+        svst1_u8(pg, dst + i, sveor_u8_x(pg, d, m));
+    }
+}
+
+#endif // HAVE_SVE
+
+// 可用内核，按优先级从高到低排列
+static const fec_kernel_t fec_kernels[] = {
+#ifdef HAVE_AVX2
+    { "GFNI-AVX-512", gf_mul_xor_gfni_avx512, gf_encode_gfni_avx512,
+      CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW | CPU_FEATURE_GFNI },
+    { "AVX-512BW",    gf_mul_xor_avx512,      gf_encode_avx512,
+      CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW },
+    { "GFNI-AVX2",    gf_mul_xor_gfni_avx2,   gf_encode_gfni_avx2,
+      CPU_FEATURE_AVX2 | CPU_FEATURE_GFNI },
+    { "AVX2",         gf_mul_xor_avx2,        gf_encode_avx2,
+      CPU_FEATURE_AVX2 },
+#endif
+#ifdef HAVE_SVE
+    { "SVE",          gf_mul_xor_sve,         NULL,
+      CPU_FEATURE_SVE },
+#endif
+#ifdef HAVE_NEON
+    { "NEON",         gf_mul_xor_neon,        gf_encode_neon,
+      CPU_FEATURE_NEON },
+#endif
+    { NULL, NULL, NULL, 0 }
+};
+
+static bool fec_kernel_usable(const fec_kernel_t *k) {
+    return (cpu_get_features() & k->features) == k->features;
+}
+
+// 按运行时 CPU 特性选择最优内核，无可用 SIMD 时返回 NULL（走标量路径）
+static const fec_kernel_t* fec_kernel_select(void) {
+    for (const fec_kernel_t *k = fec_kernels; k->name; k++) {
+        if (fec_kernel_usable(k)) return k;
+    }
+    return NULL;
+}
+
+bool fec_simd_available(void) {
+    return fec_kernel_select() != NULL;
+}
+
+// 无专用分块内核时的条带宽度：ps 行校验条带 + ds 行数据条带常驻 L1
+#define FEC_ENCODE_STRIPE   1024
+
+// 按条带调用 mul_xor，效果同分块内核，只是数据在条带内被重复读取（L1 命中）
+static int rs_encode_striped(const fec_kernel_t *kern,
+                             const uint8_t *const data[], int data_count,
+                             uint8_t *const parity[], int parity_count, int len,
+                             const gf_coef_t coef[][FEC_MAX_DATA_SHARDS]) {
+    for (int i = 0; i < len; i += FEC_ENCODE_STRIPE) {
+        int n = len - i < FEC_ENCODE_STRIPE ? len - i : FEC_ENCODE_STRIPE;
+        for (int p = 0; p < parity_count; p++) {
+            memset(parity[p] + i, 0, n);
+        }
+        for (int d = 0; d < data_count; d++) {
+            for (int p = 0; p < parity_count; p++) {
+                kern->mul_xor(parity[p] + i, data[d] + i, &coef[p][d], n);
+            }
+        }
+    }
+    return len;
+}
+
+// 数据分片以指针 + 长度给出（可直接指向接收缓冲区），
+// 长度不足 shard_size 的部分按 0 参与计算，无需补齐拷贝
+//
+// 默认按列分块：所有分片共有的前缀交给分块内核，每个数据字节只从内存读一次；
+// row_order 为真时退回逐行顺序（每行校验都完整扫一遍全部数据），仅供基准对比
+static void rs_encode_simd(const fec_kernel_t *kern,
+                           const uint8_t *const data[],
+                           const size_t data_lens[],
+                           int data_count,
+                           uint8_t *const parity[],
+                           int parity_count,
+                           int shard_size,
+                           const gf_coef_t coef[][FEC_MAX_DATA_SHARDS],
+                           bool row_order) {
+    int done = 0;
+    
+    if (!row_order) {
+        int common = shard_size;
+        for (int d = 0; d < data_count; d++) {
+            if ((int)data_lens[d] < common) common = (int)data_lens[d];
+        }
+        done = kern->encode ? kern->encode(data, data_count, parity, parity_count, common, coef)
+                            : rs_encode_striped(kern, data, data_count, parity, parity_count,
+                                                common, coef);
+    }
+    
+    // 剩余部分（分块内核的不足一个向量的尾部、较长分片超出公共前缀的部分）
+    for (int p = 0; p < parity_count; p++) {
+        memset(parity[p] + done, 0, shard_size - done);
+        
+        for (int d = 0; d < data_count; d++) {
+            if ((int)data_lens[d] > done) {
+                kern->mul_xor(parity[p] + done, data[d] + done, &coef[p][d],
+                              (int)data_lens[d] - done);
+            }
+        }
+    }
+}
+
+// =========================================================
+// RS 简单实现（无 SIMD）
+// =========================================================
+static void rs_encode_simple(const uint8_t *const data[],
+                             const size_t data_lens[],
+                             int data_count,
+                             uint8_t *const parity[],
+                             int parity_count,
+                             int shard_size,
+                             const uint8_t matrix[][FEC_MAX_DATA_SHARDS]) {
+    for (int p = 0; p < parity_count; p++) {
+        memset(parity[p], 0, shard_size);
+        for (int d = 0; d < data_count; d++) {
+            gf_mul_xor_scalar(parity[p], data[d], matrix[p][d], data_lens[d]);
+        }
+    }
+}
+
+// =========================================================
+// Cauchy 位矩阵 + XOR 调度（无乘法）
+// =========================================================
+// 每个分片切成 8 个等长小包，GF(2^8) 系数 c 展开为 8x8 的 GF(2) 位矩阵：
+//   第 b 列 = c * 2^b 的比特，输出小包 a = XOR { 输入小包 b | M_c[a][b] = 1 }
+// 编码只剩整块异或，不依赖 SIMD 查表指令，适合 SSE2 / 无 SIMD 主机
+// （位矩阵是乘法的同构表示，生成矩阵与逆矩阵仍沿用 Cauchy 矩阵）
+//
+// 注意小包布局与按字节的 RS 不兼容，收发两端须同为 FEC_TYPE_RS_CAUCHY
+#define CAUCHY_ALIGN        64      // 分片大小取 64 的倍数，小包按 8 字节字异或
+#define CAUCHY_MAX_SHARD    ((FEC_SHARD_SIZE - FEC_HEADER_SIZE) & ~(CAUCHY_ALIGN - 1))
+#define CAUCHY_ROWS         (FEC_MAX_PARITY_SHARDS * 8)
+#define CAUCHY_COLS         (FEC_MAX_DATA_SHARDS * 8)
+#define CAUCHY_WORDS        ((CAUCHY_COLS + 63) / 64)
+
+typedef struct {
+    uint16_t dst;           // 校验小包 p * 8 + a
+    uint16_t src;           // 数据小包 d * 8 + b，或 from_parity 时为校验小包
+    uint8_t  copy;          // 1 = 赋值（每行第一条），0 = 异或
+    uint8_t  from_parity;
+} cauchy_op_t;
+
+// 每个 (ds, ps) 只在 rs_engine_setup 时计算一次
+typedef struct {
+    int          op_count;
+    cauchy_op_t  ops[CAUCHY_ROWS * (CAUCHY_COLS + 1)];
+} cauchy_sched_t;
+
+static inline int cauchy_bit(uint8_t c, int a, int b) {
+    return (gf_mul_table[c][1 << b] >> a) & 1;
+}
+
+static inline int bits_popcount(const uint64_t *v) {
+    int n = 0;
+    for (int w = 0; w < CAUCHY_WORDS; w++) n += __builtin_popcountll(v[w]);
+    return n;
+}
+
+static inline int bits_distance(const uint64_t *a, const uint64_t *b) {
+    int n = 0;
+    for (int w = 0; w < CAUCHY_WORDS; w++) n += __builtin_popcountll(a[w] ^ b[w]);
+    return n;
+}
+
+// 生成 XOR 调度：每个校验小包要么从零累加（popcount 次操作），
+// 要么复制一个已算出的校验小包再异或差异列（距离 + 1 次操作），
+// 每步贪心挑选代价最小的未完成行
+static void cauchy_schedule_build(cauchy_sched_t *sc,
+                                  const uint8_t matrix[][FEC_MAX_DATA_SHARDS],
+                                  int data_count, int parity_count) {
+    uint64_t rows[CAUCHY_ROWS][CAUCHY_WORDS];
+    int rows_n = parity_count * 8;
+    
+    memset(rows, 0, sizeof(rows));
+    for (int p = 0; p < parity_count; p++) {
+        for (int a = 0; a < 8; a++) {
+            for (int d = 0; d < data_count; d++) {
+                for (int b = 0; b < 8; b++) {
+                    if (cauchy_bit(matrix[p][d], a, b)) {
+                        int col = d * 8 + b;
+                        rows[p * 8 + a][col / 64] |= 1ULL << (col % 64);
+                    }
+                }
+            }
+        }
+    }
+    
+    bool done[CAUCHY_ROWS] = { false };
+    int best_base[CAUCHY_ROWS];     // -1 = 从零累加
+    int best_cost[CAUCHY_ROWS];
+    for (int r = 0; r < rows_n; r++) {
+        best_base[r] = -1;
+        best_cost[r] = bits_popcount(rows[r]);
+    }
+    
+    sc->op_count = 0;
+    for (int step = 0; step < rows_n; step++) {
+        int r = -1;
+        for (int i = 0; i < rows_n; i++) {
+            if (!done[i] && (r < 0 || best_cost[i] < best_cost[r])) r = i;
+        }
+        
+        const uint64_t *base = best_base[r] >= 0 ? rows[best_base[r]] : NULL;
+        bool first = true;
+        if (base) {
+            sc->ops[sc->op_count++] = (cauchy_op_t){ r, best_base[r], 1, 1 };
+            first = false;
+        }
+        for (int col = 0; col < data_count * 8; col++) {
+            uint64_t bit = 1ULL << (col % 64);
+            bool want = rows[r][col / 64] & bit;
+            bool have = base && (base[col / 64] & bit);
+            if (want != have) {
+                sc->ops[sc->op_count++] = (cauchy_op_t){ r, col, first, 0 };
+                first = false;
+            }
+        }
+        done[r] = true;
+        
+        // 新完成的行可作为其余行的起点
+        for (int i = 0; i < rows_n; i++) {
+            if (done[i]) continue;
+            int cost = bits_distance(rows[i], rows[r]) + 1;
+            if (cost < best_cost[i]) {
+                best_cost[i] = cost;
+                best_base[i] = r;
+            }
+        }
+    }
+}
+
+// 数据分片须为完整的 shard_size（不足部分已补 0）
+static void cauchy_encode(const cauchy_sched_t *sc,
+                          const uint8_t *const data[],
+                          uint8_t *const parity[],
+                          int shard_size) {
+    size_t pkt = shard_size / 8;
+    
+    for (int i = 0; i < sc->op_count; i++) {
+        const cauchy_op_t *op = &sc->ops[i];
+        uint8_t *dst = parity[op->dst >> 3] + (op->dst & 7) * pkt;
+        const uint8_t *src = op->from_parity
+            ? parity[op->src >> 3] + (op->src & 7) * pkt
+            : data[op->src >> 3] + (op->src & 7) * pkt;
+        
+        if (op->copy) {
+            memcpy(dst, src, pkt);
+        } else {
+            xor_region(dst, src, pkt);
+        }
+    }
+}
+
+// 解码用：dst ^= c * src（小包布局，直接按位矩阵异或，不做调度优化）
+static void cauchy_mul_xor(uint8_t *dst, const uint8_t *src, uint8_t c, int shard_size) {
+    size_t pkt = shard_size / 8;
+    
+    for (int a = 0; a < 8; a++) {
+        for (int b = 0; b < 8; b++) {
+            if (cauchy_bit(c, a, b)) {
+                xor_region(dst + a * pkt, src + b * pkt, pkt);
+            }
+        }
+    }
+}
+
+// =========================================================
+// RS 解码（高斯消元）
+// =========================================================
+// 逆矩阵缓存：有损链路上同一丢包模式会反复出现，
+// 按 (ds, ps, 参与解码的分片位图) 缓存逆矩阵，命中时只需应用矩阵
+#define RS_INV_CACHE_SIZE   16      // 16 x ~410 B，常驻 L1/L2
+
+typedef struct {
+    uint32_t mask;          // 参与解码的 ds 个分片位图，0 = 空槽
+    uint8_t  data_count;
+    uint8_t  parity_count;
+    uint32_t last_use;
+    uint8_t  inv[FEC_MAX_DATA_SHARDS][FEC_MAX_DATA_SHARDS];
+} rs_inv_entry_t;
+
+typedef struct {
+    rs_inv_entry_t entries[RS_INV_CACHE_SIZE];
+    uint32_t       tick;
+} rs_inv_cache_t;
+
+// 求解码矩阵（mask 选中的前 ds 个分片）的逆中丢失数据分片对应的行，
+// 奇异时返回 -1。恢复只用到这些行，其余行不写。
+//
+// 到达的数据分片在解码矩阵里是单位行，可直接消去：设丢失数据分片集合 L
+// （k 个），所用校验分片 P（同为 k 个），生成矩阵 C，则
+//   y_P = C[P][D] x_D + S x_L，S = C[P][L]（k x k）
+//   x_L = S^-1 y_P + S^-1 C[P][D] x_D
+// 只需对 k x k 的 S 求逆（Gauss-Jordan），代价 k^3 + k^2 (ds - k)，
+// 而不是对整个 ds x ds 矩阵求逆。inv 的列按分片在解码输入中的顺序排列
+static int rs_invert(int data_count, int parity_count, uint32_t mask,
+                     uint8_t inv[][FEC_MAX_DATA_SHARDS]) {
+    uint8_t gen[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
+    rs_matrix_build(gen, data_count, parity_count);
+    
+    // 列位置：到达的数据分片与所用校验分片在解码输入中的下标
+    int lost[FEC_MAX_PARITY_SHARDS], used[FEC_MAX_PARITY_SHARDS];
+    int data_pos[FEC_MAX_DATA_SHARDS], used_pos[FEC_MAX_PARITY_SHARDS];
+    int k = 0, n_used = 0, idx = 0;
+    for (int i = 0; i < data_count + parity_count && idx < data_count; i++) {
+        bool here = mask & (1u << i);
+        if (i < data_count) {
+            if (here) {
+                data_pos[i] = idx++;
+            } else {
+                if (k == FEC_MAX_PARITY_SHARDS) return -1;
+                data_pos[i] = -1;
+                lost[k++] = i;
+            }
+        } else if (here) {
+            used_pos[n_used] = idx++;
+            used[n_used++] = i - data_count;
+        }
+    }
+    if (idx < data_count || n_used != k) return -1;
+    
+    // S 求逆，结果在 s_inv
+    uint8_t sub[FEC_MAX_PARITY_SHARDS][FEC_MAX_PARITY_SHARDS];
+    uint8_t s_inv[FEC_MAX_PARITY_SHARDS][FEC_MAX_PARITY_SHARDS];
+    for (int a = 0; a < k; a++) {
+        for (int b = 0; b < k; b++) {
+            sub[a][b] = gen[used[a]][lost[b]];
+            s_inv[a][b] = a == b;
+        }
     }
     
-    // 高斯消元
-    uint8_t inv[FEC_MAX_DATA_SHARDS][FEC_MAX_DATA_SHARDS];
-    memset(inv, 0, sizeof(inv));
-    for (int i = 0; i < data_count; i++) inv[i][i] = 1;
-    
-    for (int col = 0; col < data_count; col++) {
+    for (int col = 0; col < k; col++) {
         // 找主元
         int pivot = -1;
-        for (int row = col; row < data_count; row++) {
-            if (matrix[row][col] != 0) {
+        for (int row = col; row < k; row++) {
+            if (sub[row][col] != 0) {
                 pivot = row;
                 break;
             }
         }
         if (pivot < 0) return -1;
         
-        // 交换
         if (pivot != col) {
-            for (int j = 0; j < data_count; j++) {
-                uint8_t t = matrix[col][j]; 
-                matrix[col][j] = matrix[pivot][j]; 
-                matrix[pivot][j] = t;
-                t = inv[col][j]; 
-                inv[col][j] = inv[pivot][j]; 
-                inv[pivot][j] = t;
+            for (int j = 0; j < k; j++) {
+                uint8_t t = sub[col][j];
+                sub[col][j] = sub[pivot][j];
+                sub[pivot][j] = t;
+                t = s_inv[col][j];
+                s_inv[col][j] = s_inv[pivot][j];
+                s_inv[pivot][j] = t;
             }
-            uint8_t *t = shard_ptrs[col];
-            shard_ptrs[col] = shard_ptrs[pivot];
-            shard_ptrs[pivot] = t;
         }
         
         // 归一化
-        uint8_t scale = gf_exp[255 - gf_log[matrix[col][col]]];
-        for (int j = 0; j < data_count; j++) {
-            matrix[col][j] = gf_mul_table[matrix[col][j]][scale];
-            inv[col][j] = gf_mul_table[inv[col][j]][scale];
+        const uint8_t *scale = gf_mul_table[gf_exp[255 - gf_log[sub[col][col]]]];
+        for (int j = 0; j < k; j++) {
+            sub[col][j] = scale[sub[col][j]];
+            s_inv[col][j] = scale[s_inv[col][j]];
         }
         
         // 消元
-        for (int row = 0; row < data_count; row++) {
-            if (row != col && matrix[row][col] != 0) {
-                uint8_t factor = matrix[row][col];
-                for (int j = 0; j < data_count; j++) {
-                    matrix[row][j] ^= gf_mul_table[matrix[col][j]][factor];
-                    inv[row][j] ^= gf_mul_table[inv[col][j]][factor];
+        for (int row = 0; row < k; row++) {
+            if (row != col && sub[row][col] != 0) {
+                const uint8_t *factor = gf_mul_table[sub[row][col]];
+                for (int j = 0; j < k; j++) {
+                    sub[row][j] ^= factor[sub[col][j]];
+                    s_inv[row][j] ^= factor[s_inv[col][j]];
                 }
             }
         }
     }
     
-    // 恢复丢失分片
-    for (int i = 0; i < data_count; i++) {
-        if (!present[i]) {
-            memset(shards[i], 0, shard_size);
-            for (int byte = 0; byte < shard_size; byte++) {
-                for (int j = 0; j < data_count; j++) {
-                    shards[i][byte] ^= gf_mul_table[shard_ptrs[j][byte]][inv[i][j]];
-                }
+    // 丢失行：校验列取 S^-1，到达数据列取 S^-1 C[P][D]
+    for (int a = 0; a < k; a++) {
+        uint8_t *row = inv[lost[a]];
+        memset(row, 0, data_count);
+        for (int b = 0; b < k; b++) {
+            row[used_pos[b]] = s_inv[a][b];
+        }
+        for (int j = 0; j < data_count; j++) {
+            if (data_pos[j] < 0) continue;
+            uint8_t acc = 0;
+            for (int b = 0; b < k; b++) {
+                acc ^= gf_mul_table[s_inv[a][b]][gen[used[b]][j]];
             }
-            present[i] = true;
+            row[data_pos[j]] = acc;
         }
     }
     
     return 0;
 }
 
-// =========================================================
-// 统一 FEC 引擎
-// =========================================================
-struct fec_engine_s {
-    fec_type_t type;
-    uint8_t    data_shards;
-    uint8_t    parity_shards;
-    float      loss_rate;
-    uint32_t   next_group_id;
+// 查找逆矩阵，未命中时求逆并替换最久未用的槽位
+static const rs_inv_entry_t* rs_inv_lookup(rs_inv_cache_t *cache,
+                                           int data_count, int parity_count,
+                                           uint32_t mask) {
+    rs_inv_entry_t *victim = &cache->entries[0];
+    cache->tick++;
+    
+    for (int i = 0; i < RS_INV_CACHE_SIZE; i++) {
+        rs_inv_entry_t *ent = &cache->entries[i];
+        if (ent->mask == mask && ent->data_count == data_count &&
+            ent->parity_count == parity_count) {
+            ent->last_use = cache->tick;
+            return ent;
+        }
+        if (ent->last_use < victim->last_use) victim = ent;
+    }
     
-    union {
-        xor_fec_t xor_ctx;
-        struct {
-            struct {
-                uint32_t group_id;
-                uint8_t  shards[FEC_MAX_TOTAL_SHARDS][FEC_SHARD_SIZE];
-                bool     present[FEC_MAX_TOTAL_SHARDS];
-                size_t   shard_size;
-                uint8_t  data_count;
-                uint8_t  parity_count;
-            } cache[64];
-            int cache_count;
-        } rs_ctx;
-    };
-};
+    if (rs_invert(data_count, parity_count, mask, victim->inv) < 0) {
+        victim->mask = 0;
+        victim->last_use = 0;
+        return NULL;
+    }
+    victim->mask = mask;
+    victim->data_count = data_count;
+    victim->parity_count = parity_count;
+    victim->last_use = cache->tick;
+    return victim;
+}
 
-fec_engine_t* fec_create(fec_type_t type, uint8_t data_shards, uint8_t parity_shards) {
-    fec_engine_t *e = calloc(1, sizeof(fec_engine_t));
-    if (!e) return NULL;
+// 丢失分片少于此数时逐行恢复：每个到达分片只重读一两次，逐行内核（系数表
+// 提到循环外、双向量展开）反而更快；更多时走分块内核
+#define FEC_RECOVER_BLOCKED_MIN     3
+
+static int rs_decode_common(uint8_t *const shards[],
+                            bool *present,
+                            int data_count,
+                            int total_count,
+                            int shard_size,
+                            const fec_kernel_t *kern,
+                            bool bitmatrix,
+                            rs_inv_cache_t *inv_cache) {
+    // 取前 ds 个到达的分片参与解码
+    const uint8_t *shard_ptrs[FEC_MAX_DATA_SHARDS];
+    uint32_t mask = 0;
     
-    // 自动选择
-    if (type == FEC_TYPE_AUTO) {
-        if (fec_simd_available()) {
-            type = FEC_TYPE_RS_SIMD;
-        } else if (data_shards <= 4 && parity_shards == 1) {
-            type = FEC_TYPE_XOR;
-        } else {
-            type = FEC_TYPE_RS_SIMPLE;
+    int idx = 0;
+    for (int i = 0; i < total_count && idx < data_count; i++) {
+        if (present[i]) {
+            mask |= 1u << i;
+            shard_ptrs[idx++] = shards[i];
         }
     }
+    if (idx < data_count) return -1;
     
-    e->type = type;
-    e->data_shards = data_shards > 0 ? data_shards : 5;
-    e->parity_shards = parity_shards > 0 ? parity_shards : 2;
+    const rs_inv_entry_t *ent = rs_inv_lookup(inv_cache, data_count,
+                                              total_count - data_count, mask);
+    if (!ent) return -1;
+    const uint8_t (*inv)[FEC_MAX_DATA_SHARDS] = ent->inv;
     
-    if (type == FEC_TYPE_XOR) {
-        e->xor_ctx.group_size = e->data_shards;
+    // 丢失的数据分片（能解码时不超过校验分片数）
+    uint8_t *lost_ptrs[FEC_MAX_PARITY_SHARDS];
+    int lost_rows[FEC_MAX_PARITY_SHARDS];
+    int lost = 0;
+    for (int i = 0; i < data_count; i++) {
+        if (!present[i]) {
+            lost_rows[lost] = i;
+            lost_ptrs[lost++] = shards[i];
+        }
+    }
+    
+    if (kern && !bitmatrix && lost >= FEC_RECOVER_BLOCKED_MIN) {
+        // 丢失行 = 逆矩阵对应行 x 到达分片，与编码同构：交给同一个分块内核，
+        // 每个到达分片只读一次，同时累加出全部丢失分片
+        gf_coef_t coef[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
+        size_t lens[FEC_MAX_DATA_SHARDS];
+        for (int r = 0; r < lost; r++) {
+            for (int j = 0; j < data_count; j++) {
+                coef[r][j] = gf_coef[inv[lost_rows[r]][j]];
+            }
+        }
+        for (int j = 0; j < data_count; j++) lens[j] = shard_size;
+        
+        rs_encode_simd(kern, shard_ptrs, lens, data_count, lost_ptrs, lost,
+                       shard_size, (const gf_coef_t (*)[FEC_MAX_DATA_SHARDS])coef, false);
+    } else {
+        for (int r = 0; r < lost; r++) {
+            const uint8_t *row = inv[lost_rows[r]];
+            memset(lost_ptrs[r], 0, shard_size);
+            for (int j = 0; j < data_count; j++) {
+                if (bitmatrix) {
+                    cauchy_mul_xor(lost_ptrs[r], shard_ptrs[j], row[j], shard_size);
+                } else if (kern) {
+                    kern->mul_xor(lost_ptrs[r], shard_ptrs[j], &gf_coef[row[j]], shard_size);
+                } else {
+                    gf_mul_xor_scalar(lost_ptrs[r], shard_ptrs[j], row[j], shard_size);
+                }
+            }
+        }
     }
     
-    gf_init();
+    for (int r = 0; r < lost; r++) present[lost_rows[r]] = true;
+    return 0;
+}
+
+// =========================================================
+// 滑动窗口 RLC（随机线性码）
+// =========================================================
+// 源包到达即发送；每 N 个源包追加 R 个修复包，每个修复包是最近 W 个
+// 源包的 GF(2^8) 随机线性组合。丢包只需等到下一个覆盖它的修复包，
+// 恢复延迟约 N 个包间隔，而不是块 RS 的整组，冗余率同样是 R/N
+//
+// 源符号 = 2 字节负载长度 + 负载，修复包长度取窗口内最长的源符号，
+// 恢复后由长度前缀还原出原始负载长度
+//
+// 分片头（shard_idx 在 h[4] 低位）：
+//   源包:   seq,  idx 0
+//   修复包: end,  idx 1 + r,  w,  R       覆盖序号 [end - w + 1, end]
+#define SLW_RING        (FEC_SLIDING_MAX_WINDOW * 2)    // 解码端跟踪的序号范围
+#define SLW_SYMBOL      (FEC_SHARD_SIZE - FEC_HEADER_SIZE)
+#define SLW_WINDOW_FACTOR   4       // 默认窗口 W = 4N
+
+// 解码方程：系数按列（seq % SLW_RING）存放，始终保持行最简形
+// （每个主元列在其它行中系数为 0），新方程只需对各行消元一次
+typedef struct {
+    uint8_t  coef[SLW_RING];
+    int      pivot;             // 主元列，-1 = 空闲
+    int      len;               // data 有效长度，之后全为 0
+    uint8_t  data[SLW_SYMBOL];
+} slw_row_t;
+
+typedef struct {
+    // 编码端：最近 W 个源符号
+    uint32_t next_seq;
+    uint32_t filled;            // 已缓存的源符号数（不超过 W）
+    uint32_t since_repair;
+    uint8_t  window;
+    uint16_t enc_len[FEC_SLIDING_MAX_WINDOW];
+    uint8_t  enc_sym[FEC_SLIDING_MAX_WINDOW][SLW_SYMBOL];
+    
+    // 解码端：跟踪序号 [hi - SLW_RING + 1, hi]
+    bool     started;
+    uint32_t hi;
+    bool     known[SLW_RING];
+    uint16_t sym_len[SLW_RING];
+    uint8_t  sym[SLW_RING][SLW_SYMBOL];
+    slw_row_t rows[SLW_RING];
+} slw_ctx_t;
+
+// 修复系数：由 (end, r, seq) 确定的伪随机非零元，两端无需传输系数向量
+static inline uint8_t slw_coef(uint32_t end, int r, uint32_t seq) {
+    uint32_t h = end * 2654435761u ^ seq * 2246822519u ^ (uint32_t)(r + 1) * 3266489917u;
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    return gf_exp[h % 255];
+}
+
+// dst ^= c * src；无 SIMD 内核时走标量内核
+static void slw_mul_xor(const fec_kernel_t *kern, uint8_t *dst, const uint8_t *src,
+                        uint8_t c, int len) {
+    if (c == 0) return;
+    if (kern) {
+        kern->mul_xor(dst, src, &gf_coef[c], len);
+        return;
+    }
+    gf_mul_xor_scalar(dst, src, c, len);
+}
+
+static void slw_write_header(uint8_t *h, uint32_t seq, uint8_t idx, uint8_t w, uint8_t r) {
+    hdr_write_common(h, seq, idx, false);
+    h[5] = w;
+    h[6] = r;
+    h[7] = 0;
+    h[8] = 0;
+    h[9] = 0;
+}
+
+static slw_ctx_t* slw_create(uint8_t window) {
+    slw_ctx_t *s = calloc(1, sizeof(slw_ctx_t));
+    if (!s) return NULL;
+    s->window = window;
+    for (int i = 0; i < SLW_RING; i++) s->rows[i].pivot = -1;
+    return s;
+}
+
+// 一个源包 -> 源分片 + （每 repair_interval 个源包）repair_count 个修复分片
+static int slw_encode(slw_ctx_t *s, const fec_kernel_t *kern,
+                      int repair_interval, int repair_count,
+                      const uint8_t *data, size_t len,
+                      uint8_t out_shards[][FEC_SHARD_SIZE],
+                      size_t out_lens[],
+                      uint32_t *group_id) {
+    if (len > FEC_SLIDING_MAX_PAYLOAD) return -1;
+    
+    uint32_t seq = s->next_seq++;
+    *group_id = seq;
+    
+    uint8_t *sym = s->enc_sym[seq % FEC_SLIDING_MAX_WINDOW];
+    sym[0] = (len >> 8) & 0xFF;
+    sym[1] = len & 0xFF;
+    memcpy(sym + 2, data, len);
+    s->enc_len[seq % FEC_SLIDING_MAX_WINDOW] = len + 2;
+    if (s->filled < s->window) s->filled++;
+    
+    slw_write_header(out_shards[0], seq, 0, 0, 0);
+    memcpy(out_shards[0] + FEC_HEADER_SIZE, data, len);
+    out_lens[0] = len + FEC_HEADER_SIZE;
+    
+    if (++s->since_repair < (uint32_t)repair_interval) return 1;
+    s->since_repair = 0;
+    
+    int w = s->filled;
+    int size = 0;
+    for (int k = 0; k < w; k++) {
+        int l = s->enc_len[(seq - k) % FEC_SLIDING_MAX_WINDOW];
+        if (l > size) size = l;
+    }
+    
+    for (int r = 0; r < repair_count; r++) {
+        uint8_t *p = out_shards[1 + r] + FEC_HEADER_SIZE;
+        memset(p, 0, size);
+        for (int k = 0; k < w; k++) {
+            uint32_t q = seq - k;
+            slw_mul_xor(kern, p, s->enc_sym[q % FEC_SLIDING_MAX_WINDOW],
+                        slw_coef(seq, r, q), s->enc_len[q % FEC_SLIDING_MAX_WINDOW]);
+        }
+        slw_write_header(out_shards[1 + r], seq, 1 + r, w, repair_count);
+        out_lens[1 + r] = size + FEC_HEADER_SIZE;
+    }
+    
+    return 1 + repair_count;
+}
+
+static void slw_row_clear(slw_row_t *row) {
+    memset(row->coef, 0, sizeof(row->coef));
+    memset(row->data, 0, row->len);
+    row->len = 0;
+    row->pivot = -1;
+}
+
+// dst += f * src（系数与数据同时）
+static void slw_row_axpy(const fec_kernel_t *kern, slw_row_t *dst, const slw_row_t *src,
+                         uint8_t f) {
+    for (int c = 0; c < SLW_RING; c++) {
+        dst->coef[c] ^= gf_mul_table[src->coef[c]][f];
+    }
+    slw_mul_xor(kern, dst->data, src->data, f, src->len);
+    if (src->len > dst->len) dst->len = src->len;
+}
+
+static inline uint32_t slw_col_seq(const slw_ctx_t *s, int col) {
+    return s->hi - ((s->hi - (uint32_t)col) & (SLW_RING - 1));
+}
+
+static inline bool slw_in_window(const slw_ctx_t *s, uint32_t seq) {
+    return (int32_t)(s->hi - seq) >= 0 && (int32_t)(s->hi - seq) < SLW_RING;
+}
+
+// 序号窗口前移：移出的列上仍有未知系数的方程已无法求解，直接丢弃
+static void slw_advance(slw_ctx_t *s, uint32_t seq) {
+    if (!s->started) {
+        s->started = true;
+        s->hi = seq;
+        return;
+    }
+    
+    int32_t d = (int32_t)(seq - s->hi);
+    if (d <= 0) return;
+    
+    if (d >= SLW_RING) {
+        memset(s->known, 0, sizeof(s->known));
+        for (int i = 0; i < SLW_RING; i++) {
+            if (s->rows[i].pivot >= 0) slw_row_clear(&s->rows[i]);
+        }
+        s->hi = seq;
+        return;
+    }
+    
+    for (uint32_t q = s->hi + 1; q != seq + 1; q++) {
+        int c = q & (SLW_RING - 1);
+        s->known[c] = false;
+        for (int i = 0; i < SLW_RING; i++) {
+            if (s->rows[i].pivot >= 0 && s->rows[i].coef[c]) slw_row_clear(&s->rows[i]);
+        }
+    }
+    s->hi = seq;
+}
+
+// 把一个方程（已消去已知源包）并入行最简形
+static void slw_insert(slw_ctx_t *s, const fec_kernel_t *kern, slw_row_t *row) {
+    for (int i = 0; i < SLW_RING; i++) {
+        slw_row_t *o = &s->rows[i];
+        if (o == row || o->pivot < 0) continue;
+        uint8_t f = row->coef[o->pivot];
+        if (f) slw_row_axpy(kern, row, o, f);
+    }
+    
+    int p = -1;
+    for (int c = 0; c < SLW_RING; c++) {
+        if (row->coef[c]) { p = c; break; }
+    }
+    if (p < 0) {
+        // 线性相关，没有新信息
+        slw_row_clear(row);
+        return;
+    }
+    
+    // 主元归一：dst ^= (c ^ 1) * dst 即 dst = c * dst，原地缩放复用 mul_xor 内核
+    uint8_t inv = gf_exp[255 - gf_log[row->coef[p]]];
+    for (int c = 0; c < SLW_RING; c++) {
+        row->coef[c] = gf_mul_table[row->coef[c]][inv];
+    }
+    slw_mul_xor(kern, row->data, row->data, inv ^ 1, row->len);
+    
+    for (int i = 0; i < SLW_RING; i++) {
+        slw_row_t *o = &s->rows[i];
+        if (o == row || o->pivot < 0) continue;
+        uint8_t f = o->coef[p];
+        if (f) slw_row_axpy(kern, o, row, f);
+    }
+    row->pivot = p;
+}
+
+static void slw_deliver(const fec_deliver_t *deliver, uint32_t seq,
+                        const uint8_t *data, size_t len) {
+    if (deliver->fn) deliver->fn(deliver->user, seq, 0, data, len);
+}
+
+// 只剩主元一个未知数的方程即为恢复出的源包；返回恢复个数，长度前缀损坏返回 -1
+static int slw_collect(slw_ctx_t *s, const fec_deliver_t *deliver) {
+    int recovered = 0;
+    
+    for (int i = 0; i < SLW_RING; i++) {
+        slw_row_t *row = &s->rows[i];
+        if (row->pivot < 0) continue;
+        
+        bool solved = true;
+        for (int c = 0; c < SLW_RING && solved; c++) {
+            if (c != row->pivot && row->coef[c]) solved = false;
+        }
+        if (!solved) continue;
+        
+        int col = row->pivot;
+        size_t len = (row->data[0] << 8) | row->data[1];
+        if (row->len < 2 || len > (size_t)row->len - 2) {
+            slw_row_clear(row);
+            return -1;
+        }
+        
+        memcpy(s->sym[col], row->data, len + 2);
+        s->sym_len[col] = len + 2;
+        s->known[col] = true;
+        slw_deliver(deliver, slw_col_seq(s, col), s->sym[col] + 2, len);
+        slw_row_clear(row);
+        recovered++;
+    }
+    
+    return recovered;
+}
+
+static int slw_decode(slw_ctx_t *s, const fec_kernel_t *kern, const fec_deliver_t *deliver,
+                      uint32_t group_id, uint8_t shard_idx,
+                      const uint8_t *shard, size_t shard_len,
+                      uint8_t *out_data, size_t *out_len) {
+    if (!hdr_valid(shard, shard_len)) return -1;
+    
+    const uint8_t *payload = shard + FEC_HEADER_SIZE;
+    size_t len = shard_len - FEC_HEADER_SIZE;
+    if (len > SLW_SYMBOL) return -1;
+    
+    if (shard_idx == 0) {
+        // 源包：立即交付，并从所有方程中消去
+        if (len > FEC_SLIDING_MAX_PAYLOAD) return -1;
+        slw_advance(s, group_id);
+        if (!slw_in_window(s, group_id)) return 0;
+        
+        int col = group_id & (SLW_RING - 1);
+        if (s->known[col]) return 0;
+        
+        uint8_t *sym = s->sym[col];
+        sym[0] = (len >> 8) & 0xFF;
+        sym[1] = len & 0xFF;
+        memcpy(sym + 2, payload, len);
+        s->sym_len[col] = len + 2;
+        s->known[col] = true;
+        
+        if (deliver->fn) {
+            slw_deliver(deliver, group_id, payload, len);
+        } else {
+            memcpy(out_data, payload, len);
+            *out_len = len;
+        }
+        
+        for (int i = 0; i < SLW_RING; i++) {
+            slw_row_t *row = &s->rows[i];
+            uint8_t f = row->coef[col];
+            if (row->pivot < 0 || !f) continue;
+            
+            slw_mul_xor(kern, row->data, sym, f, s->sym_len[col]);
+            if (s->sym_len[col] > row->len) row->len = s->sym_len[col];
+            row->coef[col] = 0;
+            
+            // 主元被消去：剩余部分作为新方程重新并入
+            if (row->pivot == col) {
+                row->pivot = -1;
+                slw_insert(s, kern, row);
+            }
+        }
+        
+        slw_collect(s, deliver);
+        return 1;
+    }
+    
+    // 修复包
+    uint32_t end = group_id;
+    int w = shard[5];
+    int r = shard_idx - 1;
+    if (w == 0 || w > FEC_SLIDING_MAX_WINDOW) return -1;
+    
+    slw_advance(s, end);
+    if (!slw_in_window(s, end - (w - 1))) return 0;
+    
+    slw_row_t *row = NULL;
+    for (int i = 0; i < SLW_RING && !row; i++) {
+        if (s->rows[i].pivot < 0) row = &s->rows[i];
+    }
+    if (!row) return 0;
+    
+    memcpy(row->data, payload, len);
+    row->len = len;
+    
+    // 消去已知源包，未知的留作方程系数
+    bool unknown = false;
+    for (int k = 0; k < w; k++) {
+        uint32_t q = end - k;
+        int col = q & (SLW_RING - 1);
+        uint8_t f = slw_coef(end, r, q);
+        if (s->known[col]) {
+            if (s->sym_len[col] > len) {
+                slw_row_clear(row);
+                return -1;
+            }
+            slw_mul_xor(kern, row->data, s->sym[col], f, s->sym_len[col]);
+        } else {
+            row->coef[col] = f;
+            unknown = true;
+        }
+    }
+    
+    if (!unknown) {
+        slw_row_clear(row);
+        return 0;
+    }
+    
+    slw_insert(s, kern, row);
+    int n = slw_collect(s, deliver);
+    return n < 0 ? -1 : (n > 0);
+}
+
+// =========================================================
+// 统一 FEC 引擎
+// =========================================================
+// 编码状态与解码状态分开分配：RS 编码矩阵只有 RS 类型才有，重组表与逆矩阵
+// 缓存在第一次解码时才创建，分片缓冲按组从共享 slab 申请
+
+// 编码矩阵缓存：仅在创建或 ds/ps 变化时重建
+typedef struct {
+    uint8_t    ds, ps;          // 矩阵对应的 ds:ps
+    uint8_t    matrix[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
+    gf_coef_t  coef[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
+} rs_encoder_t;
+
+typedef struct {
+    fec_slot_table_t slots;     // 解码重组表
+    rs_inv_cache_t *inv_cache;  // 解码逆矩阵 LRU，第一次需要矩阵恢复时创建
+} fec_decoder_t;
+
+struct fec_engine_s {
+    fec_type_t type;
+    uint8_t    data_shards;
+    uint8_t    parity_shards;
+    float      loss_rate;
+    uint32_t   next_group_id;
+    const fec_kernel_t *kern;   // RS-SIMD 内核，NULL = 标量
+    fec_decoder_t *dec;         // 解码状态，首次解码时创建（只发送的引擎不占用）
+    uint32_t   dec_slots;       // 重组表槽位数
+    uint64_t   timeout_ns;      // 重组超时
+    fec_deliver_t deliver;      // 系统码模式交付回调，fn 为 NULL 时整组输出
+    fec_deliver_t partial;      // 整组输出模式下放弃的组交付已到达的数据分片
+    slw_ctx_t *slw;             // 滑动窗口 RLC 状态（仅 FEC_TYPE_SLIDING）
+    cauchy_sched_t *cauchy;     // 位矩阵 XOR 调度（仅 FEC_TYPE_RS_CAUCHY）
+    xor2d_ctx_t *x2d;           // 二维 XOR 编码状态（仅 FEC_TYPE_XOR_2D）
+    bool       row_order;       // 逐行编码（旧循环顺序），仅基准测试对比用
+    bool       unpadded;        // 数据分片不补齐发送
+    bool       xor_groups;      // RS 引擎改以单校验 XOR 组编码（fec_reconfigure 选择）
+    rs_encoder_t *enc;          // RS 编码矩阵（仅 RS 类型）
+    xor_fec_t  xor_ctx;
+};
+
+static inline bool engine_is_rs(const fec_engine_t *e) {
+    return e->type == FEC_TYPE_RS_SIMPLE || e->type == FEC_TYPE_RS_SIMD ||
+           e->type == FEC_TYPE_RS_CAUCHY;
+}
+
+static uint32_t engine_max_shards(const fec_engine_t *e) {
+    switch (e->type) {
+    case FEC_TYPE_XOR:     return FEC_XOR_GROUP_SIZE + 1;
+    case FEC_TYPE_SLIDING: return 1;   // 不使用分组重组表
+    case FEC_TYPE_XOR_2D:  return x2d_total(e->data_shards, e->parity_shards);
+    default:               return FEC_MAX_TOTAL_SHARDS;
+    }
+}
+
+// 重建编码矩阵，并按矩阵顺序展开每个系数的 SIMD 表
+static void rs_engine_setup(fec_engine_t *e) {
+    rs_encoder_t *enc = e->enc;
+    if (!enc) return;
+    
+    rs_matrix_build(enc->matrix, e->data_shards, e->parity_shards);
+    
+    for (int p = 0; p < e->parity_shards; p++) {
+        for (int d = 0; d < e->data_shards; d++) {
+            enc->coef[p][d] = gf_coef[enc->matrix[p][d]];
+        }
+    }
+    
+    if (e->cauchy) {
+        cauchy_schedule_build(e->cauchy, enc->matrix, e->data_shards, e->parity_shards);
+    }
+    enc->ds = e->data_shards;
+    enc->ps = e->parity_shards;
+}
+
+// 引擎的 ds:ps 改变后调用（包括切到 XOR 组期间，fec_encode_iov 仍按 RS 编码）
+static void rs_engine_sync(fec_engine_t *e) {
+    if (e->enc && (e->enc->ds != e->data_shards || e->enc->ps != e->parity_shards)) {
+        rs_engine_setup(e);
+    }
+}
+
+// 取解码状态，第一次解码时创建
+// 系统码模式与二维 XOR 的数据分片到达即交付，放弃时无需再交付
+static void engine_sync_flush(fec_engine_t *e) {
+    if (!e->dec) return;
+    bool whole_group = !e->deliver.fn && e->type != FEC_TYPE_XOR_2D;
+    e->dec->slots.flush_fn = whole_group ? e->partial.fn : NULL;
+    e->dec->slots.flush_user = e->partial.user;
+}
+
+static fec_decoder_t* engine_decoder(fec_engine_t *e) {
+    if (e->dec) return e->dec;
+    
+    fec_decoder_t *d = calloc(1, sizeof(fec_decoder_t));
+    if (!d) return NULL;
+    if (slot_table_init(&d->slots, e->dec_slots, engine_max_shards(e)) < 0) {
+        free(d);
+        return NULL;
+    }
+    d->slots.timeout_ns = e->timeout_ns;
+    e->dec = d;
+    engine_sync_flush(e);
+    return d;
+}
+
+fec_engine_t* fec_create(fec_type_t type, uint8_t data_shards, uint8_t parity_shards) {
+    fec_engine_t *e = calloc(1, sizeof(fec_engine_t));
+    if (!e) return NULL;
+    
+    // 自动选择
+    if (type == FEC_TYPE_AUTO) {
+        if (fec_simd_available()) {
+            type = FEC_TYPE_RS_SIMD;
+        } else if (data_shards <= 4 && parity_shards == 1) {
+            type = FEC_TYPE_XOR;
+        } else {
+            type = FEC_TYPE_RS_SIMPLE;
+        }
+    }
+    
+    // SIMD 内核在创建时一次选定；CPU 不支持时回退到查表法
+    if (type == FEC_TYPE_RS_SIMD) {
+        e->kern = fec_kernel_select();
+        if (!e->kern) type = FEC_TYPE_RS_SIMPLE;
+    } else if (type == FEC_TYPE_SLIDING) {
+        e->kern = fec_kernel_select();
+    }
+    
+    e->type = type;
+    e->data_shards = data_shards > 0 ? data_shards : 5;
+    e->parity_shards = parity_shards > 0 ? parity_shards : 2;
+    if (e->data_shards > FEC_MAX_DATA_SHARDS) e->data_shards = FEC_MAX_DATA_SHARDS;
+    if (e->parity_shards > FEC_MAX_PARITY_SHARDS) e->parity_shards = FEC_MAX_PARITY_SHARDS;
+    
+    if (type == FEC_TYPE_XOR) {
+        if (e->data_shards > FEC_XOR_GROUP_SIZE) e->data_shards = FEC_XOR_GROUP_SIZE;
+        e->xor_ctx.group_size = e->data_shards;
+    }
+    
+    // 二维 XOR：data_shards = 行宽 L，parity_shards = 深度 D，块内分片数不超过上限
+    if (type == FEC_TYPE_XOR_2D) {
+        if (e->data_shards < 2) e->data_shards = 2;
+        if (e->data_shards > FEC_XOR2D_MAX_WIDTH) e->data_shards = FEC_XOR2D_MAX_WIDTH;
+        while (e->parity_shards > 1 &&
+               x2d_total(e->data_shards, e->parity_shards) > FEC_MAX_TOTAL_SHARDS) {
+            e->parity_shards--;
+        }
+        e->x2d = calloc(1, sizeof(xor2d_ctx_t));
+        if (!e->x2d) {
+            fec_destroy(e);
+            return NULL;
+        }
+        e->x2d->width = e->data_shards;
+        e->x2d->depth = e->parity_shards;
+    }
+    
+    if (engine_is_rs(e)) {
+        e->enc = malloc(sizeof(rs_encoder_t));
+        if (!e->enc) {
+            fec_destroy(e);
+            return NULL;
+        }
+    }
+    if (type == FEC_TYPE_RS_CAUCHY) {
+        e->cauchy = malloc(sizeof(cauchy_sched_t));
+        if (!e->cauchy) {
+            fec_destroy(e);
+            return NULL;
+        }
+    }
+    rs_engine_setup(e);
+    
+    // 滑动窗口：data_shards = 修复间隔 N，parity_shards = 每次修复包数 R
+    if (type == FEC_TYPE_SLIDING) {
+        int w = SLW_WINDOW_FACTOR * e->data_shards;
+        if (w > FEC_SLIDING_MAX_WINDOW) w = FEC_SLIDING_MAX_WINDOW;
+        e->slw = slw_create((uint8_t)w);
+        if (!e->slw) {
+            fec_destroy(e);
+            return NULL;
+        }
+    }
+    
+    // 解码状态延迟到第一次解码时创建
+    e->dec_slots = FEC_DEFAULT_SLOTS;
+    e->timeout_ns = FEC_DEFAULT_GROUP_TIMEOUT * 1000000ULL;
+    
+    return e;
+}
+
+void fec_destroy(fec_engine_t *e) {
+    if (!e) return;
+    if (e->dec) {
+        slot_table_free(&e->dec->slots);
+        free(e->dec->inv_cache);
+        free(e->dec);
+    }
+    free(e->enc);
+    free(e->cauchy);
+    free(e->x2d);
+    free(e->slw);
+    free(e);
+}
+
+int fec_set_decode_slots(fec_engine_t *e, uint32_t slots) {
+    if (e->dec && slot_table_init(&e->dec->slots, slots, engine_max_shards(e)) < 0) return -1;
+    e->dec_slots = slots;
+    return 0;
+}
+
+void fec_set_group_timeout(fec_engine_t *e, uint32_t timeout_ms) {
+    e->timeout_ns = timeout_ms * 1000000ULL;
+    if (e->dec) {
+        e->dec->slots.timeout_ns = e->timeout_ns;
+        e->dec->slots.next_sweep_ns = 0;
+    }
+}
+
+int fec_decode_expire(fec_engine_t *e) {
+    if (!e->dec) return 0;
+    return slot_sweep(&e->dec->slots, get_time_ns());
+}
+
+void fec_set_systematic(fec_engine_t *e, fec_deliver_fn deliver, void *user) {
+    e->deliver.fn = deliver;
+    e->deliver.user = user;
+    engine_sync_flush(e);
+}
+
+void fec_set_partial_handler(fec_engine_t *e, fec_deliver_fn fn, void *user) {
+    e->partial.fn = fn;
+    e->partial.user = user;
+    engine_sync_flush(e);
+}
+
+void fec_set_unpadded(fec_engine_t *e, bool unpadded) {
+    e->unpadded = unpadded;
+}
+
+int fec_set_sliding_window(fec_engine_t *e, uint8_t window) {
+    if (!e->slw || window < e->data_shards || window > FEC_SLIDING_MAX_WINDOW) return -1;
+    e->slw->window = window;
+    if (e->slw->filled > window) e->slw->filled = window;
+    return 0;
+}
+
+// RS 分片头：公共部分 + ds(1) + ps(4 位) | STREAM(1 位) | shard_size(11 位) + 组负载长度(2)
+// STREAM 位（FEC_HDR_RS_STREAM）在此清零，由流式编码器写头后置位
+// payload_len < 0 表示不带长度（零拷贝接口，各数据分片长度由调用方决定）
+static void rs_write_header(uint8_t *h, uint32_t group_id, uint8_t shard_idx,
+                            uint8_t ds, uint8_t ps, size_t shard_size, long payload_len) {
+    hdr_write_common(h, group_id, shard_idx, payload_len >= 0);
+    h[5] = ds;
+    h[6] = (ps << 4) | ((shard_size >> 8) & 0x07);
+    h[7] = shard_size & 0xFF;
+    h[8] = payload_len >= 0 ? (payload_len >> 8) & 0xFF : 0;
+    h[9] = payload_len >= 0 ? payload_len & 0xFF : 0;
+}
+
+static void rs_encode_parity(const fec_engine_t *e,
+                             const uint8_t *const data[], const size_t data_lens[], int ds,
+                             uint8_t *const parity[], int ps, size_t shard_size) {
+    if (e->kern) {
+        rs_encode_simd(e->kern, data, data_lens, ds, parity, ps, shard_size, e->enc->coef,
+                       e->row_order);
+    } else {
+        rs_encode_simple(data, data_lens, ds, parity, ps, shard_size, e->enc->matrix);
+    }
+}
+
+size_t fec_max_payload(const fec_engine_t *e) {
+    const size_t shard = FEC_SHARD_SIZE - FEC_HEADER_SIZE;
+    
+    switch (e->type) {
+    case FEC_TYPE_XOR:     return e->xor_ctx.group_size * shard;
+    case FEC_TYPE_SLIDING: return FEC_SLIDING_MAX_PAYLOAD;
+    case FEC_TYPE_XOR_2D:  return FEC_XOR2D_MAX_PAYLOAD;
+    default: break;
+    }
+    
+    // RS：XOR 组不受 Cauchy 的 64 字节对齐限制
+    if (e->cauchy && !e->xor_groups) return (size_t)e->data_shards * CAUCHY_MAX_SHARD;
+    return e->data_shards * shard;
+}
+
+// 编码一个 RS 组：只读引擎的矩阵与内核，不修改任何状态，
+// 组号由调用方分配，因此可在多个线程上并发执行
+static int rs_encode_group(const fec_engine_t *e, uint32_t group_id,
+                           const uint8_t *data, size_t len,
+                           uint8_t out_shards[][FEC_SHARD_SIZE],
+                           size_t out_lens[]) {
+    uint8_t ds = e->data_shards;
+    uint8_t ps = e->parity_shards;
+    
+    if (e->xor_groups) {
+        return xor_encode_group(ds, group_id, data, len, out_shards, out_lens, e->unpadded);
+    }
+    
+    size_t shard_size = (len + ds - 1) / ds;
+    if (shard_size > FEC_SHARD_SIZE - FEC_HEADER_SIZE) shard_size = FEC_SHARD_SIZE - FEC_HEADER_SIZE;
+    if (e->cauchy) {
+        shard_size = (shard_size + CAUCHY_ALIGN - 1) & ~(size_t)(CAUCHY_ALIGN - 1);
+        if (shard_size > CAUCHY_MAX_SHARD) shard_size = CAUCHY_MAX_SHARD;
+    }
+    
+    // 分割数据：直接引用输入，不做中间拷贝
+    const uint8_t *data_ptrs[FEC_MAX_DATA_SHARDS] = { 0 };
+    size_t data_lens[FEC_MAX_DATA_SHARDS] = { 0 };
+    
+    size_t offset = 0;
+    for (int i = 0; i < ds; i++) {
+        size_t n = offset < len ? len - offset : 0;
+        if (n > shard_size) n = shard_size;
+        data_ptrs[i] = data + offset;
+        data_lens[i] = n;
+        offset += n;
+    }
+    
+    // 校验直接写入输出分片
+    uint8_t *parity_ptrs[FEC_MAX_PARITY_SHARDS] = { 0 };
+    for (int i = 0; i < ps; i++) {
+        parity_ptrs[i] = out_shards[ds + i] + FEC_HEADER_SIZE;
+    }
+    
+    // 打包输出；不补齐模式下数据分片只发送有效长度
+    int total = ds + ps;
+    for (int i = 0; i < total; i++) {
+        rs_write_header(out_shards[i], group_id, i, ds, ps, shard_size, (long)offset);
+        out_lens[i] = (e->unpadded && i < ds ? data_lens[i] : shard_size) + FEC_HEADER_SIZE;
+    }
+    for (int i = 0; i < ds; i++) {
+        memcpy(out_shards[i] + FEC_HEADER_SIZE, data_ptrs[i], data_lens[i]);
+        if (data_lens[i] < shard_size) {
+            memset(out_shards[i] + FEC_HEADER_SIZE + data_lens[i], 0,
+                   shard_size - data_lens[i]);
+        }
+    }
+    
+    // 位矩阵调度按小包读取数据，从已补齐的输出分片取数
+    if (e->cauchy) {
+        const uint8_t *packed[FEC_MAX_DATA_SHARDS];
+        for (int i = 0; i < ds; i++) packed[i] = out_shards[i] + FEC_HEADER_SIZE;
+        cauchy_encode(e->cauchy, packed, parity_ptrs, shard_size);
+    } else {
+        rs_encode_parity(e, data_ptrs, data_lens, ds, parity_ptrs, ps, shard_size);
+    }
+    
+    return total;
+}
+
+int fec_encode(fec_engine_t *e,
+               const uint8_t *data, size_t len,
+               uint8_t out_shards[][FEC_SHARD_SIZE],
+               size_t out_lens[],
+               uint32_t *group_id) {
+    
+    // 超出一组容量的部分无处可放，拒绝而不是截断（不占用组号）
+    if (len > fec_max_payload(e)) return -1;
+    
+    if (e->type == FEC_TYPE_XOR) {
+        return xor_encode(&e->xor_ctx, data, len, out_shards, out_lens, group_id,
+                          e->unpadded);
+    }
+    
+    if (e->type == FEC_TYPE_SLIDING) {
+        return slw_encode(e->slw, e->kern, e->data_shards, e->parity_shards,
+                          data, len, out_shards, out_lens, group_id);
+    }
+    
+    if (e->type == FEC_TYPE_XOR_2D) {
+        return x2d_encode(e->x2d, data, len, out_shards, out_lens, group_id);
+    }
+    
+    // RS 编码
+    *group_id = e->next_group_id++;
+    return rs_encode_group(e, *group_id, data, len, out_shards, out_lens);
+}
+
+int fec_encode_iov(fec_engine_t *e,
+                   const struct iovec *data, int data_count,
+                   uint8_t *const parity[],
+                   size_t *shard_size,
+                   uint32_t *group_id) {
+    if (!engine_is_rs(e) || e->cauchy || data_count != e->data_shards) return -1;
+    
+    const uint8_t *data_ptrs[FEC_MAX_DATA_SHARDS];
+    size_t data_lens[FEC_MAX_DATA_SHARDS];
+    size_t max_len = 0;
+    
+    for (int i = 0; i < data_count; i++) {
+        if (data[i].iov_len > FEC_SHARD_SIZE - FEC_HEADER_SIZE) return -1;
+        data_ptrs[i] = data[i].iov_base;
+        data_lens[i] = data[i].iov_len;
+        if (data_lens[i] > max_len) max_len = data_lens[i];
+    }
+    
+    size_t ss = max_len;
+    
+    *group_id = e->next_group_id++;
+    
+    uint8_t *parity_ptrs[FEC_MAX_PARITY_SHARDS];
+    for (int i = 0; i < e->parity_shards; i++) {
+        parity_ptrs[i] = parity[i] + FEC_HEADER_SIZE;
+        rs_write_header(parity[i], *group_id, e->data_shards + i,
+                        e->data_shards, e->parity_shards, ss, -1);
+    }
+    rs_encode_parity(e, data_ptrs, data_lens, data_count,
+                     parity_ptrs, e->parity_shards, ss);
+    
+    *shard_size = ss;
+    return e->parity_shards;
+}
+
+void fec_write_header(fec_engine_t *e, uint8_t *hdr,
+                      uint32_t group_id, uint8_t shard_idx, size_t shard_size) {
+    rs_write_header(hdr, group_id, shard_idx,
+                    e->data_shards, e->parity_shards, shard_size, -1);
+}
+
+int fec_decode(fec_engine_t *e,
+               uint32_t group_id,
+               uint8_t shard_idx,
+               const uint8_t *shard_data, size_t shard_len,
+               uint8_t *out_data, size_t *out_len) {
+    
+    if (!hdr_valid(shard_data, shard_len)) return -1;
+    
+    if (e->type == FEC_TYPE_SLIDING) {
+        return slw_decode(e->slw, e->kern, &e->deliver, group_id, shard_idx,
+                          shard_data, shard_len, out_data, out_len);
+    }
+    
+    fec_decoder_t *dec = engine_decoder(e);
+    if (!dec) return -1;
+    
+    if (e->type == FEC_TYPE_XOR) {
+        return xor_decode(&dec->slots, &e->deliver, group_id, shard_idx, 
+                          shard_data, shard_len, out_data, out_len);
+    }
+    
+    if (e->type == FEC_TYPE_XOR_2D) {
+        return x2d_decode(&dec->slots, &e->deliver, group_id, shard_idx,
+                          shard_data, shard_len, out_data, out_len);
+    }
+    
+    // RS 解码
+    uint8_t ds = shard_data[5];
+    uint8_t ps = shard_data[6] >> 4;
+    bool stream = shard_data[6] & FEC_HDR_RS_STREAM;
+    size_t shard_size = ((shard_data[6] & 0x07) << 8) | shard_data[7];
+    bool has_len = hdr_has_len(shard_data);
+    size_t payload_len = has_len ? (size_t)((shard_data[8] << 8) | shard_data[9])
+                                 : (size_t)ds * shard_size;
+    int total = ds + ps;
+    
+    // XOR 组头部 [6] 是 shard_size 高字节（不超过 5），ps 位恒为 0；RS 组 ps >= 1。
+    // 发送端可在 RS 与 XOR 之间切换（fec_reconfigure），接收端无需协商
+    if (ps == 0) {
+        return xor_decode(&dec->slots, &e->deliver, group_id, shard_idx,
+                          shard_data, shard_len, out_data, out_len);
+    }
+    
+    if (ds == 0 || ds > FEC_MAX_DATA_SHARDS || ps > FEC_MAX_PARITY_SHARDS) return -1;
+    
+    if (shard_idx >= total || shard_size > FEC_SHARD_SIZE - FEC_HEADER_SIZE ||
+        payload_len > ds * shard_size) return -1;
+    if (e->type == FEC_TYPE_RS_CAUCHY && (shard_size % 8 || stream)) return -1;
+    
+    size_t n = shard_len - FEC_HEADER_SIZE;
+    const uint8_t *len_table = NULL;
+    if (stream) {
+        // 流式编码组：数据分片即原始包；校验分片只到组内最长包，末尾是长度表
+        if (shard_idx >= ds) {
+            if (n < 2u * ds) return -1;
+            n -= 2 * ds;
+            len_table = shard_data + FEC_HEADER_SIZE + n;
+            for (int i = 0; i < ds; i++) {
+                if ((size_t)((len_table[2 * i] << 8) | len_table[2 * i + 1]) > n) return -1;
+            }
+        }
+        if (n > shard_size || (shard_idx < ds && n == 0)) return -1;
+    } else {
+        // 数据分片可以不补齐（按 0 扩展，带长度时不能短于有效长度），校验分片必须完整
+        if (n > shard_size) n = shard_size;
+        size_t need = shard_idx >= ds ? shard_size :
+                      has_len ? shard_data_len(payload_len, shard_size, shard_idx) : 0;
+        if (n < need) return -1;
+    }
+    
+    // 已完成组的迟到分片（通常是多余的校验）：不拷贝、不占槽
+    if (slot_is_late(&dec->slots, group_id)) return 0;
+    
+    // 查找缓存
+    fec_slot_t *slot = slot_acquire(&dec->slots, group_id);
+    if (slot_prepare(&dec->slots, slot, ds, ps, shard_size) < 0) return -1;
+    if (slot->present_count == 0) {
+        slot->payload_len = payload_len;
+        slot->stream = stream;
+    } else if (slot->stream != stream) {
+        return -1;
+    }
+    
+    // 保存分片，系统码模式下数据分片立即交付（只交付有效长度）
+    bool fresh = !slot->present[shard_idx];
+    int present_count = slot_store(slot, shard_idx, shard_data + FEC_HEADER_SIZE, n);
+    if (stream && fresh) {
+        if (shard_idx < ds) {
+            slot->lens[shard_idx] = n;
+        } else if (!slot->has_lens) {
+            present_count = slot_stream_lens(slot, len_table);
+        }
+    }
+    size_t dlen = has_len ? shard_data_len(payload_len, shard_size, shard_idx) : n;
+    if (e->deliver.fn && fresh && shard_idx < ds && dlen > 0) {
+        e->deliver.fn(e->deliver.user, group_id, shard_idx, shard_data + FEC_HEADER_SIZE, dlen);
+    }
+    
+    if (present_count < ds) return 0;
+    
+    // 数据分片全部到齐时无需任何矩阵运算
+    if (slot->data_present < ds) {
+        bool missing[FEC_MAX_DATA_SHARDS];
+        for (int i = 0; i < ds; i++) missing[i] = !slot->present[i];
+        
+        uint8_t *shards[FEC_MAX_TOTAL_SHARDS];
+        for (int i = 0; i < total; i++) shards[i] = slot_shard(slot, i);
+        
+        if (!dec->inv_cache) dec->inv_cache = calloc(1, sizeof(rs_inv_cache_t));
+        
+        // 流式编码组只需恢复到组内最长包（校验分片也只有这么长）
+        size_t sym_len = shard_size;
+        if (slot->stream) {
+            sym_len = 0;
+            for (int i = 0; i < ds; i++) {
+                if (slot->lens[i] > sym_len) sym_len = slot->lens[i];
+            }
+        }
+        
+        // 恢复
+        if (!dec->inv_cache ||
+            rs_decode_common(shards, slot->present,
+                             ds, total, sym_len, e->kern,
+                             e->type == FEC_TYPE_RS_CAUCHY, dec->inv_cache) < 0) {
+            dec->slots.groups_failed++;
+            slot_complete(&dec->slots, slot);
+            return -1;
+        }
+        slot->recovered = true;
+        
+        if (e->deliver.fn) {
+            for (int i = 0; i < ds; i++) {
+                size_t l = slot_data_len(slot, i);
+                if (missing[i] && l > 0) {
+                    e->deliver.fn(e->deliver.user, group_id, i, slot_shard(slot, i), l);
+                }
+            }
+        }
+    }
+    
+    // 拼接，按精确负载长度截去补齐
+    if (!e->deliver.fn) {
+        *out_len = 0;
+        for (int i = 0; i < ds; i++) {
+            size_t l = slot_data_len(slot, i);
+            memcpy(out_data + *out_len, slot_shard(slot, i), l);
+            *out_len += l;
+        }
+    }
+    
+    slot_complete(&dec->slots, slot);
+    return 1;
+}
+
+void fec_set_loss_rate(fec_engine_t *e, float loss_rate) {
+    e->loss_rate = loss_rate;
+    
+    if (e->type == FEC_TYPE_XOR || e->type == FEC_TYPE_XOR_2D) {
+        // XOR 不支持动态调整
+        return;
+    }
+    
+    // RS 动态调整
+    uint8_t ps;
+    if (loss_rate < 0.05f) {
+        ps = 2;
+    } else if (loss_rate < 0.10f) {
+        ps = 3;
+    } else if (loss_rate < 0.20f) {
+        ps = 4;
+    } else if (loss_rate < 0.30f) {
+        ps = 5;
+    } else {
+        ps = e->data_shards;  // 最大 100% 冗余
+    }
+    if (ps > FEC_MAX_PARITY_SHARDS) ps = FEC_MAX_PARITY_SHARDS;
+    
+    // 只调整校验数，不撤销 fec_reconfigure / 控制器选择的 XOR 组
+    e->parity_shards = ps;
+    rs_engine_sync(e);
+}
+
+fec_type_t fec_get_type(fec_engine_t *e) {
+    return e->type;
+}
+
+const char* fec_get_kernel_name(fec_engine_t *e) {
+    return e->kern ? e->kern->name : "Scalar";
+}
+
+int fec_reconfigure(fec_engine_t *e, fec_type_t type, uint8_t data_shards, uint8_t parity_shards) {
+    if (data_shards < 1 || data_shards > FEC_MAX_DATA_SHARDS) return -1;
+    
+    if (e->type == FEC_TYPE_XOR) {
+        if (type != FEC_TYPE_XOR || data_shards > FEC_XOR_GROUP_SIZE) return -1;
+        e->data_shards = data_shards;
+        e->xor_ctx.group_size = data_shards;
+        return 0;
+    }
+    
+    if (!engine_is_rs(e)) return -1;
+    
+    if (type == FEC_TYPE_XOR) {
+        e->data_shards = data_shards;
+        e->xor_groups = true;
+        rs_engine_sync(e);
+        return 0;
+    }
+    
+    if (type != e->type || parity_shards < 1 || parity_shards > FEC_MAX_PARITY_SHARDS ||
+        data_shards + parity_shards > FEC_MAX_TOTAL_SHARDS) return -1;
+    
+    e->xor_groups = false;
+    e->data_shards = data_shards;
+    e->parity_shards = parity_shards;
+    rs_engine_sync(e);
+    return 0;
+}
+
+void fec_get_decode_stats(const fec_engine_t *e, fec_decode_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!e->dec) return;
+    
+    const fec_slot_table_t *t = &e->dec->slots;
+    stats->groups_recovered = t->groups_recovered;
+    stats->groups_failed = t->groups_failed;
+    stats->groups_abandoned = t->groups_abandoned;
+    stats->shards_flushed = t->shards_flushed;
+    stats->late_shards = t->late_shards;
+}
+
+void fec_get_mem_stats(const fec_engine_t *e, fec_mem_stats_t *stats) {
+    stats->engine_bytes = sizeof(fec_engine_t);
+    if (e->enc) stats->engine_bytes += sizeof(rs_encoder_t);
+    if (e->cauchy) stats->engine_bytes += sizeof(cauchy_sched_t);
+    if (e->x2d) stats->engine_bytes += sizeof(xor2d_ctx_t);
+    if (e->slw) stats->engine_bytes += sizeof(slw_ctx_t);
+    
+    stats->decoder_bytes = 0;
+    stats->shard_bytes = 0;
+    stats->groups_active = 0;
+    if (e->dec) {
+        stats->decoder_bytes = sizeof(fec_decoder_t) +
+                               (size_t)(e->dec->slots.mask + 1) * sizeof(fec_slot_t);
+        if (e->dec->inv_cache) stats->decoder_bytes += sizeof(rs_inv_cache_t);
+        stats->shard_bytes = e->dec->slots.shard_bytes;
+        stats->groups_active = e->dec->slots.groups_active;
+    }
+}
+
+// =========================================================
+// 自适应 FEC 控制器
+// =========================================================
+// 链路模型：丢包以突发为单位出现，每个分片以 q = loss / burst 的概率开始一次
+// 突发，每次突发丢 burst 个分片。一组 n = ds + ps 个分片中突发次数近似
+// 二项分布 B(n, q)，突发次数超过 ps / burst 时该组无法恢复。
+// 每个窗口为每个 ds 找出满足目标失败率的最小 ps，在带宽预算内取冗余占比
+// 最低的 (ds, ps)，相同时取较小的 ds（组越小，恢复等待越短）。
+// 闭环：窗口内出现恢复失败的组时放大 q 的裕量，平稳时裕量逐渐回落
+#define FEC_CTRL_ALPHA_UP       0.5f    // 丢包上升时的平滑系数（快升）
+#define FEC_CTRL_ALPHA_DOWN     0.125f  // 丢包下降时的平滑系数（慢降）
+#define FEC_CTRL_MARGIN_MAX     8.0f
+#define FEC_CTRL_DEADBAND       0.02f   // 冗余占比变化小于此值时不降低保护
+
+// 一组突发次数超过 ps / burst 的概率（二项分布尾部，不依赖 libm）
+static float ctrl_fail_prob(int n, int ps, float q, float burst) {
+    if (q <= 0.0f) return 0.0f;
+    if (q >= 1.0f) return 1.0f;
+    
+    int k_max = (int)(ps / burst);
+    if (k_max >= n) return 0.0f;
+    
+    double p_k = 1.0;
+    for (int i = 0; i < n; i++) p_k *= 1.0 - q;
+    
+    double cdf = p_k;
+    double ratio = q / (1.0 - q);
+    for (int k = 0; k < k_max; k++) {
+        p_k *= (double)(n - k) / (k + 1) * ratio;
+        cdf += p_k;
+    }
+    return cdf >= 1.0 ? 0.0f : (float)(1.0 - cdf);
+}
+
+static inline float ctrl_overhead(uint8_t ds, uint8_t ps) {
+    return (float)ps / (ds + ps);
+}
+
+// 按当前估计选择 (ds, ps)；预算内达不到目标时返回 false，输出预算内失败率最低的配置
+static bool ctrl_choose(const fec_ctrl_t *c, uint8_t *out_ds, uint8_t *out_ps) {
+    float burst = c->mean_burst > 1.0f ? c->mean_burst : 1.0f;
+    float q = c->loss_rate * c->margin / burst;
+    
+    // 预算连 ps = 1 都容不下（max_overhead 过小）时退到最省的配置
+    *out_ds = c->max_data_shards;
+    *out_ps = 1;
+    
+    bool found = false;
+    float best_ovh = 2.0f;
+    float best_fail = 2.0f;
+    
+    for (int ds = 2; ds <= c->max_data_shards; ds++) {
+        int ps_max = FEC_MAX_TOTAL_SHARDS - ds;
+        if (ps_max > FEC_MAX_PARITY_SHARDS) ps_max = FEC_MAX_PARITY_SHARDS;
+        
+        for (int ps = 1; ps <= ps_max; ps++) {
+            float ovh = ctrl_overhead(ds, ps);
+            if (ovh > c->max_overhead) break;
+            
+            float fail = ctrl_fail_prob(ds + ps, ps, q, burst);
+            if (fail <= c->target_fail) {
+                // 同一 ds 下更大的 ps 只会更贵
+                if (!found || ovh < best_ovh) {
+                    found = true;
+                    best_ovh = ovh;
+                    *out_ds = ds;
+                    *out_ps = ps;
+                }
+                break;
+            }
+            // 预算不足时比较每个数据分片摊到的失败概率，避免偏向小组
+            if (!found && fail / ds < best_fail) {
+                best_fail = fail / ds;
+                *out_ds = ds;
+                *out_ps = ps;
+            }
+        }
+    }
+    return found;
+}
+
+void fec_ctrl_init(fec_ctrl_t *c, fec_type_t base_type, float max_overhead) {
+    memset(c, 0, sizeof(*c));
+    c->base_type = base_type;
+    c->max_overhead = max_overhead > 0.0f ? max_overhead : 0.5f;
+    c->target_fail = 0.001f;
+    c->max_data_shards = 10;
+    c->hold_windows = 4;
+    c->mean_burst = 1.0f;
+    c->margin = 1.0f;
+    
+    c->type = base_type;
+    c->data_shards = 5;
+    c->parity_shards = 2;
+}
+
+bool fec_ctrl_update(fec_ctrl_t *c, const fec_loss_window_t *w) {
+    c->windows++;
+    if (c->max_data_shards < 2) c->max_data_shards = 2;
+    if (c->max_data_shards > FEC_MAX_DATA_SHARDS) c->max_data_shards = FEC_MAX_DATA_SHARDS;
+    c->groups_recovered += w->groups_recovered;
+    c->groups_failed += w->groups_failed;
+    
+    // 平滑丢包率与平均突发长度：上升快、下降慢
+    if (w->packets > 0) {
+        float loss = (float)w->lost / w->packets;
+        float alpha = loss > c->loss_rate ? FEC_CTRL_ALPHA_UP : FEC_CTRL_ALPHA_DOWN;
+        c->loss_rate += alpha * (loss - c->loss_rate);
+        
+        if (w->bursts > 0) {
+            float burst = (float)w->lost / w->bursts;
+            alpha = burst > c->mean_burst ? FEC_CTRL_ALPHA_UP : FEC_CTRL_ALPHA_DOWN;
+            c->mean_burst += alpha * (burst - c->mean_burst);
+        }
+    }
+    
+    // 闭环裕量：模型认为当前配置够用却仍有组没救回来，说明低估了丢包，
+    // 放大裕量；受预算限制本就达不到目标时不放大。没有失败时逐渐回落
+    float burst = c->mean_burst > 1.0f ? c->mean_burst : 1.0f;
+    float fail = ctrl_fail_prob(c->data_shards + c->parity_shards, c->parity_shards,
+                                c->loss_rate * c->margin / burst, burst);
+    if (w->groups_failed > 0 && fail <= c->target_fail) {
+        c->margin *= 1.5f;
+        if (c->margin > FEC_CTRL_MARGIN_MAX) c->margin = FEC_CTRL_MARGIN_MAX;
+    } else if (w->groups_failed == 0) {
+        c->margin = 1.0f + (c->margin - 1.0f) * 0.75f;
+    }
+    
+    uint8_t ds, ps;
+    if (!ctrl_choose(c, &ds, &ps)) c->budget_capped++;
+    
+    if (ds == c->data_shards && ps == c->parity_shards) {
+        c->pending_windows = 0;
+        return false;
+    }
+    
+    // 提升保护立即生效；降低需连续 hold_windows 个窗口确认，且变化超过死区，
+    // 确认期间取各窗口中最保守的候选
+    float cur = ctrl_overhead(c->data_shards, c->parity_shards);
+    float ovh = ctrl_overhead(ds, ps);
+    if (ovh <= cur) {
+        if (cur - ovh < FEC_CTRL_DEADBAND) {
+            c->pending_windows = 0;
+            c->held++;
+            return false;
+        }
+        if (c->pending_windows == 0 ||
+            ovh > ctrl_overhead(c->pending_ds, c->pending_ps)) {
+            c->pending_ds = ds;
+            c->pending_ps = ps;
+        }
+        if (++c->pending_windows < c->hold_windows) {
+            c->held++;
+            return false;
+        }
+        ds = c->pending_ds;
+        ps = c->pending_ps;
+        c->lowers++;
+    } else {
+        c->raises++;
+    }
+    c->pending_windows = 0;
+    
+    // 单校验时 XOR 与 RS 恢复能力相同，XOR 更省 CPU
+    fec_type_t type = ps == 1 ? FEC_TYPE_XOR : c->base_type;
+    if (type != c->type) c->type_switches++;
+    
+    c->type = type;
+    c->data_shards = ds;
+    c->parity_shards = ps;
+    return true;
+}
+
+int fec_ctrl_apply(const fec_ctrl_t *c, fec_engine_t *e) {
+    return fec_reconfigure(e, c->type, c->data_shards, c->parity_shards);
+}
+
+// =========================================================
+// 跨组交织（发送端）
+// =========================================================
+// 攒够 depth 组后按分片序号轮转发出：g0[0] g1[0] ... g0[1] g1[1] ...，
+// 长度为 B 的连续丢包落到每组约 B / depth 个分片。最早一组等待超过预算时
+// 不再等满，立即按轮转发出已缓冲的组，附加时延不超过预算。
+// 每组的缓冲按实际分片字节申请并重复使用，空闲时不再分配
+typedef struct {
+    uint8_t  *buf;
+    size_t   cap;
+    uint32_t off[FEC_MAX_TOTAL_SHARDS];
+    uint16_t len[FEC_MAX_TOTAL_SHARDS];
+    int      count;
+} ilv_group_t;
+
+struct fec_interleaver_s {
+    uint8_t     depth;
+    uint64_t    budget_ns;
+    fec_send_fn send;
+    void        *user;
+    
+    ilv_group_t groups[FEC_INTERLEAVE_MAX_DEPTH];
+    int         held;           // 已缓冲的组数
+    uint64_t    first_ns;       // 最早一组的入队时间
     
-    return e;
+    fec_interleaver_stats_t stats;
+};
+
+fec_interleaver_t* fec_interleaver_create(uint8_t depth, uint32_t budget_us,
+                                          fec_send_fn send, void *user) {
+    if (depth < 1 || depth > FEC_INTERLEAVE_MAX_DEPTH || !send) return NULL;
+    
+    fec_interleaver_t *ilv = calloc(1, sizeof(fec_interleaver_t));
+    if (!ilv) return NULL;
+    
+    ilv->depth = depth;
+    ilv->budget_ns = budget_us * 1000ULL;
+    ilv->send = send;
+    ilv->user = user;
+    return ilv;
 }
 
-void fec_destroy(fec_engine_t *e) {
-    if (e) free(e);
+void fec_interleaver_destroy(fec_interleaver_t *ilv) {
+    if (!ilv) return;
+    for (int g = 0; g < FEC_INTERLEAVE_MAX_DEPTH; g++) free(ilv->groups[g].buf);
+    free(ilv);
 }
 
-int fec_encode(fec_engine_t *e,
-               const uint8_t *data, size_t len,
-               uint8_t out_shards[][FEC_SHARD_SIZE],
-               size_t out_lens[],
-               uint32_t *group_id) {
-    
-    if (e->type == FEC_TYPE_XOR) {
-        return xor_encode(&e->xor_ctx, data, len, out_shards, out_lens, group_id);
+int fec_interleaver_flush(fec_interleaver_t *ilv) {
+    int max_count = 0;
+    for (int g = 0; g < ilv->held; g++) {
+        if (ilv->groups[g].count > max_count) max_count = ilv->groups[g].count;
     }
     
-    // RS 编码
-    *group_id = e->next_group_id++;
+    int sent = 0;
+    for (int i = 0; i < max_count; i++) {
+        for (int g = 0; g < ilv->held; g++) {
+            if (i >= ilv->groups[g].count) continue;
+            ilv->send(ilv->user, ilv->groups[g].buf + ilv->groups[g].off[i],
+                      ilv->groups[g].len[i]);
+            sent++;
+        }
+    }
     
-    uint8_t ds = e->data_shards;
-    uint8_t ps = e->parity_shards;
+    ilv->stats.shards += sent;
+    ilv->held = 0;
+    return sent;
+}
+
+int fec_interleaver_push(fec_interleaver_t *ilv,
+                         const uint8_t shards[][FEC_SHARD_SIZE],
+                         const size_t lens[], int count) {
+    if (count < 0 || count > FEC_MAX_TOTAL_SHARDS) return -1;
+    
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        if (lens[i] > FEC_SHARD_SIZE) return -1;
+        total += lens[i];
+    }
     
-    size_t shard_size = (len + ds - 1) / ds;
-    if (shard_size > FEC_SHARD_SIZE - 8) shard_size = FEC_SHARD_SIZE - 8;
+    // depth = 1 不交织，直接发出
+    if (ilv->depth == 1) {
+        for (int i = 0; i < count; i++) ilv->send(ilv->user, shards[i], lens[i]);
+        ilv->stats.groups++;
+        ilv->stats.shards += count;
+        return count;
+    }
     
-    // 分割数据
-    uint8_t data_buf[FEC_MAX_DATA_SHARDS][FEC_SHARD_SIZE];
-    memset(data_buf, 0, sizeof(data_buf));
+    ilv_group_t *grp = &ilv->groups[ilv->held];
+    if (total > grp->cap) {
+        uint8_t *buf = realloc(grp->buf, total);
+        if (!buf) return -1;
+        grp->buf = buf;
+        grp->cap = total;
+    }
     
-    size_t offset = 0;
-    for (int i = 0; i < ds && offset < len; i++) {
-        size_t copy = (len - offset > shard_size) ? shard_size : (len - offset);
-        memcpy(data_buf[i], data + offset, copy);
-        offset += copy;
+    size_t off = 0;
+    for (int i = 0; i < count; i++) {
+        memcpy(grp->buf + off, shards[i], lens[i]);
+        grp->off[i] = off;
+        grp->len[i] = lens[i];
+        off += lens[i];
     }
+    grp->count = count;
     
-    // 生成校验
-    uint8_t parity_buf[FEC_MAX_PARITY_SHARDS][FEC_SHARD_SIZE];
+    uint64_t now = get_time_ns();
+    if (ilv->held++ == 0) ilv->first_ns = now;
+    ilv->stats.groups++;
     
-#ifdef HAVE_AVX2
-    if (e->type == FEC_TYPE_RS_SIMD) {
-        rs_encode_avx2(data_buf, ds, parity_buf, ps, shard_size);
-    } else
-#endif
-#ifdef HAVE_NEON
-    if (e->type == FEC_TYPE_RS_SIMD) {
-        rs_encode_neon(data_buf, ds, parity_buf, ps, shard_size);
-    } else
-#endif
-    {
-        rs_encode_simple(data_buf, ds, parity_buf, ps, shard_size);
+    if (ilv->held == ilv->depth) {
+        ilv->stats.full_rounds++;
+        return fec_interleaver_flush(ilv);
     }
-    
-    // 打包输出
-    int total = ds + ps;
-    for (int i = 0; i < ds; i++) {
-        out_shards[i][0] = (*group_id >> 24) & 0xFF;
-        out_shards[i][1] = (*group_id >> 16) & 0xFF;
-        out_shards[i][2] = (*group_id >> 8) & 0xFF;
-        out_shards[i][3] = *group_id & 0xFF;
-        out_shards[i][4] = i;
-        out_shards[i][5] = ds;
-        out_shards[i][6] = ps;
-        out_shards[i][7] = (shard_size >> 4) & 0xFF;
-        memcpy(out_shards[i] + 8, data_buf[i], shard_size);
-        out_lens[i] = shard_size + 8;
+    if (now - ilv->first_ns >= ilv->budget_ns) {
+        ilv->stats.deadline_flushes++;
+        return fec_interleaver_flush(ilv);
     }
+    return 0;
+}
+
+int fec_interleaver_poll(fec_interleaver_t *ilv) {
+    if (ilv->held == 0 || get_time_ns() - ilv->first_ns < ilv->budget_ns) return 0;
+    ilv->stats.deadline_flushes++;
+    return fec_interleaver_flush(ilv);
+}
+
+uint32_t fec_interleaver_timeout_us(const fec_interleaver_t *ilv) {
+    if (ilv->held == 0) return UINT32_MAX;
     
-    for (int i = 0; i < ps; i++) {
-        int idx = ds + i;
-        out_shards[idx][0] = (*group_id >> 24) & 0xFF;
-        out_shards[idx][1] = (*group_id >> 16) & 0xFF;
-        out_shards[idx][2] = (*group_id >> 8) & 0xFF;
-        out_shards[idx][3] = *group_id & 0xFF;
-        out_shards[idx][4] = idx;
-        out_shards[idx][5] = ds;
-        out_shards[idx][6] = ps;
-        out_shards[idx][7] = (shard_size >> 4) & 0xFF;
-        memcpy(out_shards[idx] + 8, parity_buf[i], shard_size);
-        out_lens[idx] = shard_size + 8;
+    uint64_t waited = get_time_ns() - ilv->first_ns;
+    return waited >= ilv->budget_ns ? 0 : (uint32_t)((ilv->budget_ns - waited + 999) / 1000);
+}
+
+void fec_interleaver_get_stats(const fec_interleaver_t *ilv, fec_interleaver_stats_t *stats) {
+    *stats = ilv->stats;
+}
+
+// =========================================================
+// 流式编码（发送端逐包）
+// =========================================================
+// 每个数据包到达即带头发出，同时乘加进各校验行的累加器；累加器就是
+// 校验分片的发送缓冲（前面留出分片头），组结束时补上长度表直接发出。
+// 累加区超出组内最长包的部分始终为 0，组结束后只清理用过的前缀
+struct fec_stream_s {
+    fec_engine_t *engine;
+    uint64_t    flush_ns;
+    fec_send_fn send;
+    void        *user;
+    
+    // 当前组
+    bool        open;
+    uint32_t    group_id;
+    uint8_t     ds, ps;
+    uint8_t     count;          // 已发出的数据分片
+    uint16_t    lens[FEC_MAX_DATA_SHARDS];
+    size_t      max_len;
+    uint64_t    open_ns;
+    
+    // 编码系数，ds:ps 变化时重建
+    uint8_t     coef_ds, coef_ps;
+    uint8_t     matrix[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
+    gf_coef_t   coef[FEC_MAX_PARITY_SHARDS][FEC_MAX_DATA_SHARDS];
+    
+    uint8_t     parity[FEC_MAX_PARITY_SHARDS][FEC_SHARD_SIZE];
+    uint8_t     pkt[FEC_SHARD_SIZE];
+    
+    fec_stream_stats_t stats;
+};
+
+fec_stream_t* fec_stream_create(fec_engine_t *e, uint32_t flush_us,
+                                fec_send_fn send, void *user) {
+    if (!e || !send) return NULL;
+    if (e->type != FEC_TYPE_RS_SIMPLE && e->type != FEC_TYPE_RS_SIMD) return NULL;
+    
+    fec_stream_t *st = calloc(1, sizeof(fec_stream_t));
+    if (!st) return NULL;
+    
+    st->engine = e;
+    st->flush_ns = flush_us * 1000ULL;
+    st->send = send;
+    st->user = user;
+    return st;
+}
+
+void fec_stream_destroy(fec_stream_t *st) {
+    free(st);
+}
+
+// 开始新组：取引擎当前的 ds:ps（XOR 组按单校验 RS 组发出）
+static void stream_open(fec_stream_t *st, uint64_t now) {
+    fec_engine_t *e = st->engine;
+    
+    st->ds = e->data_shards;
+    st->ps = e->xor_groups ? 1 : e->parity_shards;
+    if (st->ds != st->coef_ds || st->ps != st->coef_ps) {
+        rs_matrix_build(st->matrix, st->ds, st->ps);
+        for (int p = 0; p < st->ps; p++) {
+            for (int d = 0; d < st->ds; d++) st->coef[p][d] = gf_coef[st->matrix[p][d]];
+        }
+        st->coef_ds = st->ds;
+        st->coef_ps = st->ps;
     }
     
-    return total;
+    st->group_id = e->next_group_id++;
+    st->count = 0;
+    st->max_len = 0;
+    st->open_ns = now;
+    st->open = true;
 }
 
-int fec_decode(fec_engine_t *e,
-               uint32_t group_id,
-               uint8_t shard_idx,
-               const uint8_t *shard_data, size_t shard_len,
-               uint8_t *out_data, size_t *out_len) {
-    
-    if (shard_len < 8) return -1;
+// 发出校验分片：校验（组内最长包的长度）+ 各数据分片长度表，未使用的分片长度为 0
+static int stream_close(fec_stream_t *st) {
+    size_t table = 2 * st->ds;
+    
+    for (int p = 0; p < st->ps; p++) {
+        uint8_t *h = st->parity[p];
+        rs_write_header(h, st->group_id, st->ds + p, st->ds, st->ps,
+                        FEC_STREAM_MAX_PAYLOAD, -1);
+        h[6] |= FEC_HDR_RS_STREAM;
+        
+        uint8_t *t = h + FEC_HEADER_SIZE + st->max_len;
+        for (int i = 0; i < st->ds; i++) {
+            uint16_t l = i < st->count ? st->lens[i] : 0;
+            t[2 * i] = l >> 8;
+            t[2 * i + 1] = l & 0xFF;
+        }
+        st->send(st->user, h, FEC_HEADER_SIZE + st->max_len + table);
+        memset(h + FEC_HEADER_SIZE, 0, st->max_len + table);
+    }
     
-    if (e->type == FEC_TYPE_XOR) {
-        return xor_decode(&e->xor_ctx, group_id, shard_idx, 
-                          shard_data, shard_len, out_data, out_len);
+    st->open = false;
+    st->stats.groups++;
+    st->stats.parity_shards += st->ps;
+    return st->ps;
+}
+
+int fec_stream_push(fec_stream_t *st, const uint8_t *data, size_t len) {
+    if (!data || len == 0 || len > FEC_STREAM_MAX_PAYLOAD) return -1;
+    
+    int sent = 0;
+    uint64_t now = get_time_ns();
+    if (st->open && now - st->open_ns >= st->flush_ns) {
+        st->stats.timer_closes++;
+        sent += stream_close(st);
+    }
+    if (!st->open) stream_open(st, now);
+    
+    // 数据分片先发出，不等校验
+    int i = st->count++;
+    rs_write_header(st->pkt, st->group_id, i, st->ds, st->ps, FEC_STREAM_MAX_PAYLOAD, -1);
+    st->pkt[6] |= FEC_HDR_RS_STREAM;
+    memcpy(st->pkt + FEC_HEADER_SIZE, data, len);
+    st->send(st->user, st->pkt, FEC_HEADER_SIZE + len);
+    sent++;
+    st->stats.data_shards++;
+    
+    const fec_kernel_t *kern = st->engine->kern;
+    for (int p = 0; p < st->ps; p++) {
+        uint8_t *acc = st->parity[p] + FEC_HEADER_SIZE;
+        if (kern) {
+            kern->mul_xor(acc, data, &st->coef[p][i], (int)len);
+        } else {
+            gf_mul_xor_scalar(acc, data, st->matrix[p][i], len);
+        }
     }
+    st->lens[i] = len;
+    if (len > st->max_len) st->max_len = len;
     
-    // RS 解码
-    uint8_t ds = shard_data[5];
-    uint8_t ps = shard_data[6];
-    size_t shard_size = shard_data[7] << 4;
-    int total = ds + ps;
+    if (st->count == st->ds) sent += stream_close(st);
+    return sent;
+}
+
+int fec_stream_poll(fec_stream_t *st) {
+    if (!st->open || get_time_ns() - st->open_ns < st->flush_ns) return 0;
+    st->stats.timer_closes++;
+    return stream_close(st);
+}
+
+int fec_stream_flush(fec_stream_t *st) {
+    return st->open ? stream_close(st) : 0;
+}
+
+uint32_t fec_stream_timeout_us(const fec_stream_t *st) {
+    if (!st->open) return UINT32_MAX;
     
-    // 查找缓存
-    int cache_idx = -1;
-    for (int i = 0; i < e->rs_ctx.cache_count; i++) {
-        if (e->rs_ctx.cache[i].group_id == group_id) {
-            cache_idx = i;
-            break;
+    uint64_t waited = get_time_ns() - st->open_ns;
+    return waited >= st->flush_ns ? 0 : (uint32_t)((st->flush_ns - waited + 999) / 1000);
+}
+
+void fec_stream_get_stats(const fec_stream_t *st, fec_stream_stats_t *stats) {
+    *stats = st->stats;
+}
+
+// =========================================================
+// 批量编码线程池
+// =========================================================
+// 调用线程按提交顺序先给每组分配组号（唯一会修改引擎的步骤），
+// 之后各组编码互不相关，由工作线程与调用线程一起按块领取
+#define FEC_BATCH_CHUNK     4       // 每次领取的组数，摊薄原子操作
+#define FEC_POOL_MAX_THREADS 64
+
+struct fec_pool_s {
+    pthread_t       threads[FEC_POOL_MAX_THREADS];
+    int             thread_count;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t  start;          // 新批次 / 退出
+    pthread_cond_t  done;           // 工作线程全部完成当前批次
+    uint64_t        generation;
+    int             running;        // 仍在处理当前批次的工作线程数
+    bool            stop;
+    
+    fec_batch_item_t *items;
+    int             count;
+    int             next;           // 下一个待领取的下标（原子）
+};
+
+static void pool_run_items(fec_pool_t *pool) {
+    for (;;) {
+        int i = __atomic_fetch_add(&pool->next, FEC_BATCH_CHUNK, __ATOMIC_RELAXED);
+        if (i >= pool->count) break;
+        
+        int end = i + FEC_BATCH_CHUNK < pool->count ? i + FEC_BATCH_CHUNK : pool->count;
+        for (; i < end; i++) {
+            fec_batch_item_t *it = &pool->items[i];
+            // 非 RS 引擎与超长数据已由调用线程处理
+            if (!engine_is_rs(it->engine) || it->len > fec_max_payload(it->engine)) continue;
+            it->result = rs_encode_group(it->engine, it->group_id, it->data, it->len,
+                                         it->out_shards, it->out_lens);
         }
     }
-    
-    if (cache_idx < 0) {
-        if (e->rs_ctx.cache_count >= 64) {
-            memmove(&e->rs_ctx.cache[0], &e->rs_ctx.cache[1],
-                    63 * sizeof(e->rs_ctx.cache[0]));
-            e->rs_ctx.cache_count = 63;
+}
+
+static void* pool_worker(void *arg) {
+    fec_pool_t *pool = arg;
+    uint64_t seen = 0;
+    
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
         }
-        cache_idx = e->rs_ctx.cache_count++;
-        memset(&e->rs_ctx.cache[cache_idx], 0, sizeof(e->rs_ctx.cache[0]));
-        e->rs_ctx.cache[cache_idx].group_id = group_id;
-        e->rs_ctx.cache[cache_idx].shard_size = shard_size;
-        e->rs_ctx.cache[cache_idx].data_count = ds;
-        e->rs_ctx.cache[cache_idx].parity_count = ps;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        
+        pool_run_items(pool);
+        
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
     }
     
-    // 保存分片
-    if (shard_idx < total) {
-        memcpy(e->rs_ctx.cache[cache_idx].shards[shard_idx], 
-               shard_data + 8, shard_size);
-        e->rs_ctx.cache[cache_idx].present[shard_idx] = true;
+    return NULL;
+}
+
+fec_pool_t* fec_pool_create(int threads) {
+    if (threads <= 0) {
+        // 调用线程本身也参与编码，工作线程数 = CPU 数 - 1
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 1 ? (int)n - 1 : 0;
     }
+    if (threads > FEC_POOL_MAX_THREADS) threads = FEC_POOL_MAX_THREADS;
     
-    // 检查
-    int present_count = 0;
-    for (int i = 0; i < total; i++) {
-        if (e->rs_ctx.cache[cache_idx].present[i]) present_count++;
-    }
+    fec_pool_t *pool = calloc(1, sizeof(fec_pool_t));
+    if (!pool) return NULL;
     
-    if (present_count < ds) return 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
     
-    // 恢复
-    if (rs_decode_common(e->rs_ctx.cache[cache_idx].shards,
-                         e->rs_ctx.cache[cache_idx].present,
-                         ds, total, shard_size) < 0) {
-        return -1;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0) break;
+        pool->thread_count++;
     }
     
-    // 拼接
-    *out_len = 0;
-    for (int i = 0; i < ds; i++) {
-        memcpy(out_data + *out_len, e->rs_ctx.cache[cache_idx].shards[i], shard_size);
-        *out_len += shard_size;
+    return pool;
+}
+
+void fec_pool_destroy(fec_pool_t *pool) {
+    if (!pool) return;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
     }
     
-    e->rs_ctx.cache[cache_idx].group_id = 0;
-    return 1;
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool);
 }
 
-void fec_set_loss_rate(fec_engine_t *e, float loss_rate) {
-    e->loss_rate = loss_rate;
+int fec_pool_threads(const fec_pool_t *pool) {
+    return pool->thread_count;
+}
+
+int fec_encode_batch(fec_pool_t *pool, fec_batch_item_t *items, int count) {
+    if (count <= 0) return 0;
+    
+    // 串行阶段：按提交顺序分配组号；XOR/滑动窗口本身有状态，直接在此编码
+    int parallel = 0;
+    for (int i = 0; i < count; i++) {
+        fec_batch_item_t *it = &items[i];
+        fec_engine_t *e = it->engine;
+        
+        if (engine_is_rs(e)) {
+            if (it->len > fec_max_payload(e)) {
+                it->result = -1;
+                continue;
+            }
+            it->group_id = e->next_group_id++;
+            parallel++;
+        } else {
+            it->result = fec_encode(e, it->data, it->len, it->out_shards, it->out_lens,
+                                    &it->group_id);
+        }
+    }
     
-    if (e->type == FEC_TYPE_XOR) {
-        // XOR 不支持动态调整
-        return;
+    if (parallel == 0) return count;
+    
+    pool->items = items;
+    pool->count = count;
+    pool->next = 0;
+    
+    // 批次太小时唤醒线程得不偿失
+    if (pool->thread_count == 0 || parallel <= FEC_BATCH_CHUNK) {
+        pool_run_items(pool);
+        return count;
     }
     
-    // RS 动态调整
-    if (loss_rate < 0.05f) {
-        e->parity_shards = 2;
-    } else if (loss_rate < 0.10f) {
-        e->parity_shards = 3;
-    } else if (loss_rate < 0.20f) {
-        e->parity_shards = 4;
-    } else if (loss_rate < 0.30f) {
-        e->parity_shards = 5;
-    } else {
-        e->parity_shards = e->data_shards;  // 最大 100% 冗余
+    pthread_mutex_lock(&pool->lock);
+    pool->running = pool->thread_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    
+    pool_run_items(pool);
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
     }
-}
-
-fec_type_t fec_get_type(fec_engine_t *e) {
-    return e->type;
+    pthread_mutex_unlock(&pool->lock);
+    
+    return count;
 }
 
 // =========================================================
 // 基准测试
 // =========================================================
-double fec_benchmark(fec_type_t type, size_t data_size, int iterations) {
-    fec_engine_t *e = fec_create(type, 5, 2);
-    if (!e) return -1;
-    
+static double bench_encode(fec_engine_t *e, size_t data_size, int iterations) {
     uint8_t *data = malloc(data_size);
+    if (!data) return -1;
     uint8_t shards[FEC_MAX_TOTAL_SHARDS][FEC_SHARD_SIZE];
     size_t lens[FEC_MAX_TOTAL_SHARDS];
     uint32_t gid;
@@ -748,7 +3529,374 @@ double fec_benchmark(fec_type_t type, size_t data_size, int iterations) {
     double throughput = (data_size * iterations) / elapsed / (1024 * 1024);
     
     free(data);
-    fec_destroy(e);
     
     return throughput;  // MB/s
 }
+
+double fec_benchmark(fec_type_t type, size_t data_size, int iterations) {
+    fec_engine_t *e = fec_create(type, 5, 2);
+    if (!e) return -1;
+    
+    double throughput = bench_encode(e, data_size, iterations);
+    fec_destroy(e);
+    
+    return throughput;
+}
+
+int fec_benchmark_kernels(size_t data_size, int iterations,
+                          fec_kernel_result_t *results, int max_results) {
+    int n = 0;
+    
+    for (const fec_kernel_t *k = fec_kernels; k->name && n < max_results; k++) {
+        if (!fec_kernel_usable(k)) continue;
+        
+        fec_engine_t *e = fec_create(FEC_TYPE_RS_SIMD, 5, 2);
+        if (!e) break;
+        e->kern = k;
+        
+        results[n].name = k->name;
+        results[n].mbps = bench_encode(e, data_size, iterations);
+        n++;
+        
+        fec_destroy(e);
+    }
+    
+    return n;
+}
+
+// 纯校验生成计时：fec_encode_iov 不做数据拷贝，差异全部来自循环顺序
+static double bench_parity(fec_engine_t *e, const struct iovec *iov,
+                           uint8_t *const parity[], size_t data_size, int iterations) {
+    size_t ss;
+    uint32_t gid;
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    for (int i = 0; i < iterations; i++) {
+        fec_encode_iov(e, iov, e->data_shards, parity, &ss, &gid);
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    double elapsed = (end.tv_sec - start.tv_sec) + 
+                     (end.tv_nsec - start.tv_nsec) / 1e9;
+    return (data_size * iterations) / elapsed / (1024 * 1024);  // MB/s
+}
+
+int fec_benchmark_blocked(uint8_t data_shards, uint8_t parity_shards,
+                          size_t data_size, int iterations,
+                          fec_blocked_result_t *results, int max_results) {
+    if (data_shards == 0 || data_shards > FEC_MAX_DATA_SHARDS ||
+        parity_shards == 0 || parity_shards > FEC_MAX_PARITY_SHARDS) return -1;
+    
+    size_t shard_size = (data_size + data_shards - 1) / data_shards;
+    if (shard_size > FEC_SHARD_SIZE - FEC_HEADER_SIZE) shard_size = FEC_SHARD_SIZE - FEC_HEADER_SIZE;
+    data_size = shard_size * data_shards;
+    
+    uint8_t *buf = malloc(data_size + (size_t)parity_shards * FEC_SHARD_SIZE);
+    if (!buf) return -1;
+    
+    struct iovec iov[FEC_MAX_DATA_SHARDS];
+    uint8_t *parity[FEC_MAX_PARITY_SHARDS];
+    for (size_t i = 0; i < data_size; i++) {
+        buf[i] = (uint8_t)(i * 7 + 3);
+    }
+    for (int d = 0; d < data_shards; d++) {
+        iov[d].iov_base = buf + d * shard_size;
+        iov[d].iov_len = shard_size;
+    }
+    for (int p = 0; p < parity_shards; p++) {
+        parity[p] = buf + data_size + (size_t)p * FEC_SHARD_SIZE;
+    }
+    
+    int n = 0;
+    for (const fec_kernel_t *k = fec_kernels; k->name && n < max_results; k++) {
+        if (!fec_kernel_usable(k)) continue;
+        
+        fec_engine_t *e = fec_create(FEC_TYPE_RS_SIMD, data_shards, parity_shards);
+        if (!e) break;
+        e->kern = k;
+        
+        results[n].name = k->name;
+        e->row_order = true;
+        results[n].row_mbps = bench_parity(e, iov, parity, data_size, iterations);
+        e->row_order = false;
+        results[n].blocked_mbps = bench_parity(e, iov, parity, data_size, iterations);
+        n++;
+        
+        fec_destroy(e);
+    }
+    
+    free(buf);
+    return n;
+}
+
+// =========================================================
+// 基准测试套件（编码 + 各种丢包模式下的解码）
+// =========================================================
+// 每个实现（查表、各 SIMD 内核、Cauchy 位矩阵）在每个 (ds, ps) 上测：
+//   编码：整组 fec_encode
+//   解码：预编码 FEC_BENCH_GROUPS 组轮流使用，丢 0..ps 个分片（随机位置 / 连续突发），
+//         把剩余分片按编号顺序交给 fec_decode，计时覆盖整组
+// 每次调用单独计时，给出吞吐（按数据字节）、每字节周期数与 p50/p99 延迟。
+// verified：编码行为各组经标量引擎从校验分片恢复后与原数据一致，
+// 解码行为每组解码结果与原数据比对一次且全部一致
+#define FEC_BENCH_GROUPS    16
+
+typedef struct {
+    const char         *name;
+    fec_type_t          type;
+    const fec_kernel_t *kern;
+} bench_impl_t;
+
+typedef struct {
+    uint8_t  ds, ps;
+    size_t   shard_size;
+    size_t   data_size;
+    uint8_t *data;                              // FEC_BENCH_GROUPS 组原始数据
+    uint8_t (*shards)[FEC_MAX_TOTAL_SHARDS][FEC_SHARD_SIZE];
+    size_t  (*lens)[FEC_MAX_TOTAL_SHARDS];
+    uint64_t *ns;                               // 每次调用耗时
+    uint8_t *out;
+} bench_ctx_t;
+
+static inline uint64_t bench_cycles(void) {
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    return 0;   // 无通用周期计数器
+#endif
+}
+
+static int bench_cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static inline uint64_t bench_rand(uint64_t *st) {
+    *st ^= *st << 13;
+    *st ^= *st >> 7;
+    *st ^= *st << 17;
+    return *st;
+}
+
+// 由每次调用耗时与总周期数填写统计项
+static void bench_finish(fec_bench_result_t *r, uint64_t *ns, int n,
+                         uint64_t cycles, size_t bytes_per_call) {
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++) total += ns[i];
+    qsort(ns, n, sizeof(uint64_t), bench_cmp_u64);
+    
+    double bytes = (double)bytes_per_call * n;
+    r->iterations = n;
+    r->mbps = total ? bytes / (total / 1e9) / (1024 * 1024) : 0;
+    r->cycles_per_byte = cycles ? cycles / bytes : 0;
+    r->p50_ns = ns[n / 2];
+    r->p99_ns = ns[(size_t)n * 99 / 100];
+}
+
+static fec_engine_t* bench_engine(const bench_impl_t *im, uint8_t ds, uint8_t ps) {
+    fec_engine_t *e = fec_create(im->type, ds, ps);
+    if (e && im->kern) e->kern = im->kern;
+    return e;
+}
+
+// 用标量查表引擎（Cauchy 用自身）解码各组编码结果：丢掉前 min(ps, ds) 个
+// 数据分片，迫使恢复走校验分片，与原数据一致才算通过
+static bool bench_encode_verify(bench_ctx_t *c, const bench_impl_t *im) {
+    fec_type_t ref = im->type == FEC_TYPE_RS_CAUCHY ? FEC_TYPE_RS_CAUCHY : FEC_TYPE_RS_SIMPLE;
+    fec_engine_t *d = fec_create(ref, c->ds, c->ps);
+    if (!d) return false;
+    
+    int drop = c->ps < c->ds ? c->ps : c->ds;
+    bool ok = true;
+    for (int g = 0; g < FEC_BENCH_GROUPS && ok; g++) {
+        size_t out_len = 0;
+        int ret = 0;
+        for (int k = drop; k < c->ds + c->ps && ret != 1; k++) {
+            uint32_t gid;
+            uint8_t idx;
+            if (fec_parse_header(c->shards[g][k], c->lens[g][k], &gid, &idx) < 0) break;
+            ret = fec_decode(d, gid, idx, c->shards[g][k], c->lens[g][k], c->out, &out_len);
+        }
+        ok = ret == 1 && out_len == c->data_size &&
+             memcmp(c->out, c->data + g * c->data_size, c->data_size) == 0;
+    }
+    
+    fec_destroy(d);
+    return ok;
+}
+
+static void bench_encode_one(bench_ctx_t *c, const bench_impl_t *im, int iterations,
+                             fec_bench_result_t *r) {
+    fec_engine_t *e = bench_engine(im, c->ds, c->ps);
+    if (!e) return;
+    uint32_t gid;
+    
+    uint64_t cyc = bench_cycles();
+    for (int i = 0; i < iterations; i++) {
+        int g = i % FEC_BENCH_GROUPS;
+        uint64_t t0 = get_time_ns();
+        fec_encode(e, c->data + g * c->data_size, c->data_size, c->shards[g], c->lens[g], &gid);
+        c->ns[i] = get_time_ns() - t0;
+    }
+    cyc = bench_cycles() - cyc;
+    
+    r->verified = bench_encode_verify(c, im);
+    bench_finish(r, c->ns, iterations, cyc, c->data_size);
+    fec_destroy(e);
+}
+
+// 按模式选出丢失的分片
+static void bench_loss_mask(bool *lost, int total, int count,
+                            fec_bench_pattern_t pattern, uint64_t *rng) {
+    memset(lost, 0, total * sizeof(bool));
+    if (count == 0) return;
+    
+    if (pattern == FEC_BENCH_LOSS_BURST) {
+        int start = bench_rand(rng) % (total - count + 1);
+        for (int i = 0; i < count; i++) lost[start + i] = true;
+        return;
+    }
+    for (int k = 0; k < count; ) {
+        int i = bench_rand(rng) % total;
+        if (!lost[i]) {
+            lost[i] = true;
+            k++;
+        }
+    }
+}
+
+static void bench_decode_one(bench_ctx_t *c, const bench_impl_t *im, int iterations,
+                             int lost_count, fec_bench_pattern_t pattern,
+                             fec_bench_result_t *r) {
+    fec_engine_t *e = bench_engine(im, c->ds, c->ps);
+    if (!e) return;
+    
+    int total = c->ds + c->ps;
+    bool lost[FEC_MAX_TOTAL_SHARDS];
+    bool checked[FEC_BENCH_GROUPS] = { false };
+    uint64_t rng = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)lost_count << 32) ^ pattern;
+    bool ok = true;
+    uint64_t cyc = 0;
+    
+    for (int i = 0; i < iterations; i++) {
+        int g = i % FEC_BENCH_GROUPS;
+        uint32_t gid = (uint32_t)i;
+        bench_loss_mask(lost, total, lost_count, pattern, &rng);
+        
+        // 每次换新组号，避免命中已完成组
+        for (int k = 0; k < total; k++) {
+            c->shards[g][k][0] = gid >> 24;
+            c->shards[g][k][1] = gid >> 16;
+            c->shards[g][k][2] = gid >> 8;
+            c->shards[g][k][3] = gid;
+        }
+        
+        size_t out_len = 0;
+        int ret = 0;
+        uint64_t c0 = bench_cycles();
+        uint64_t t0 = get_time_ns();
+        for (int k = 0; k < total; k++) {
+            if (lost[k]) continue;
+            int rr = fec_decode(e, gid, k, c->shards[g][k], c->lens[g][k], c->out, &out_len);
+            if (rr != 0) ret = rr;
+        }
+        c->ns[i] = get_time_ns() - t0;
+        cyc += bench_cycles() - c0;
+        
+        if (!checked[g]) {
+            checked[g] = true;
+            if (ret != 1 || out_len != c->data_size ||
+                memcmp(c->out, c->data + g * c->data_size, c->data_size) != 0) ok = false;
+        }
+    }
+    
+    r->verified = ok;
+    bench_finish(r, c->ns, iterations, cyc, c->data_size);
+    fec_destroy(e);
+}
+
+int fec_benchmark_suite(const fec_bench_config_t *cfg,
+                        fec_bench_report_fn report, void *user) {
+    static const uint8_t default_grid[][2] = { {5, 2}, {10, 4}, {20, 10} };
+    const uint8_t (*grid)[2] = cfg && cfg->grid_count > 0 ? cfg->grid : default_grid;
+    int grid_count = cfg && cfg->grid_count > 0 ? cfg->grid_count
+                                                : (int)(sizeof(default_grid) / sizeof(default_grid[0]));
+    int iterations = cfg && cfg->iterations > 0 ? cfg->iterations : 2000;
+    if (iterations < FEC_BENCH_GROUPS) iterations = FEC_BENCH_GROUPS;     // 编码阶段要填满全部预编码组
+    size_t shard_size = cfg && cfg->shard_size > 0 ? cfg->shard_size : 1024;
+    if (shard_size > CAUCHY_MAX_SHARD) shard_size = CAUCHY_MAX_SHARD;
+    shard_size &= ~(size_t)(CAUCHY_ALIGN - 1);      // Cauchy 需要 64 字节对齐，各实现用同一大小
+    if (shard_size == 0) shard_size = CAUCHY_ALIGN;
+    
+    // 实现列表：查表、各可用 SIMD 内核、Cauchy 位矩阵
+    bench_impl_t impls[16];
+    int impl_count = 0;
+    impls[impl_count++] = (bench_impl_t){ "Scalar", FEC_TYPE_RS_SIMPLE, NULL };
+    for (const fec_kernel_t *k = fec_kernels; k->name && impl_count < 15; k++) {
+        if (fec_kernel_usable(k)) impls[impl_count++] = (bench_impl_t){ k->name, FEC_TYPE_RS_SIMD, k };
+    }
+    impls[impl_count++] = (bench_impl_t){ "Cauchy", FEC_TYPE_RS_CAUCHY, NULL };
+    
+    bench_ctx_t c = { 0 };
+    c.shard_size = shard_size;
+    c.data = malloc((size_t)FEC_BENCH_GROUPS * FEC_MAX_DATA_SHARDS * shard_size);
+    c.shards = malloc(sizeof(*c.shards) * FEC_BENCH_GROUPS);
+    c.lens = malloc(sizeof(*c.lens) * FEC_BENCH_GROUPS);
+    c.ns = malloc(sizeof(uint64_t) * iterations);
+    c.out = malloc((size_t)FEC_MAX_DATA_SHARDS * FEC_SHARD_SIZE);
+    
+    int count = -1;
+    if (!c.data || !c.shards || !c.lens || !c.ns || !c.out) goto out;
+    
+    // 随机数据，避免固定模式被分支预测或压缩式优化放大
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < (size_t)FEC_BENCH_GROUPS * FEC_MAX_DATA_SHARDS * shard_size; i++) {
+        c.data[i] = (uint8_t)bench_rand(&rng);
+    }
+    
+    count = 0;
+    for (int gi = 0; gi < grid_count; gi++) {
+        uint8_t ds = grid[gi][0], ps = grid[gi][1];
+        if (ds == 0 || ds > FEC_MAX_DATA_SHARDS || ps == 0 || ps > FEC_MAX_PARITY_SHARDS ||
+            ds + ps > FEC_MAX_TOTAL_SHARDS) continue;
+        c.ds = ds;
+        c.ps = ps;
+        c.data_size = (size_t)ds * shard_size;
+        
+        for (int ii = 0; ii < impl_count; ii++) {
+            const bench_impl_t *im = &impls[ii];
+            fec_bench_result_t r = {
+                .impl = im->name, .data_shards = ds, .parity_shards = ps,
+                .shard_size = shard_size, .op = FEC_BENCH_ENCODE,
+            };
+            
+            // 编码（同时生成解码用的分片）
+            bench_encode_one(&c, im, iterations, &r);
+            if (report) report(user, &r);
+            count++;
+            
+            r.op = FEC_BENCH_DECODE;
+            for (int lost = 0; lost <= ps; lost++) {
+                for (int pat = FEC_BENCH_LOSS_RANDOM; pat <= FEC_BENCH_LOSS_BURST; pat++) {
+                    if (lost <= 1 && pat == FEC_BENCH_LOSS_BURST) continue;  // 与随机相同
+                    r.pattern = lost == 0 ? FEC_BENCH_LOSS_NONE : (fec_bench_pattern_t)pat;
+                    r.lost = lost;
+                    bench_decode_one(&c, im, iterations, lost, r.pattern, &r);
+                    if (report) report(user, &r);
+                    count++;
+                }
+            }
+        }
+    }
+    
+out:
+    free(c.data);
+    free(c.shards);
+    free(c.lens);
+    free(c.ns);
+    free(c.out);
+    return count;
+}
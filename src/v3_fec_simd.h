@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <sys/uio.h>
 
 // =========================================================
 // FEC 类型选择
@@ -16,6 +17,9 @@ typedef enum {
     FEC_TYPE_XOR,           // 简单 XOR（低 CPU，低恢复能力）
     FEC_TYPE_RS_SIMPLE,     // RS 查表法（中 CPU，高恢复能力）
     FEC_TYPE_RS_SIMD,       // RS SIMD 加速（高恢复能力，需要 AVX2/NEON）
+    FEC_TYPE_SLIDING,       // 滑动窗口 RLC（低恢复延迟，适合 VoIP/游戏）
+    FEC_TYPE_RS_CAUCHY,     // Cauchy 位矩阵 RS，纯异或编码（无 SIMD 查表的主机）
+    FEC_TYPE_XOR_2D,        // 二维 XOR（行 + 列校验），低 CPU 且能恢复突发丢包
     FEC_TYPE_AUTO,          // 自动选择
 } fec_type_t;
 
@@ -26,7 +30,13 @@ typedef enum {
 #define FEC_MAX_PARITY_SHARDS   10
 #define FEC_MAX_TOTAL_SHARDS    30
 #define FEC_SHARD_SIZE          1400
+#define FEC_HEADER_SIZE         10      // 每个分片前的 FEC 头
+#define FEC_HEADER_VERSION      1       // 头部格式版本（h[4] 高 2 位）
 #define FEC_XOR_GROUP_SIZE      4       // XOR 模式：每 4 个数据包生成 1 个校验包
+#define FEC_SLIDING_MAX_WINDOW  32      // 滑动窗口模式：修复包最多覆盖的源包数
+#define FEC_SLIDING_MAX_PAYLOAD (FEC_SHARD_SIZE - FEC_HEADER_SIZE - 2)
+#define FEC_XOR2D_MAX_WIDTH     8       // 二维 XOR 模式：每行最多源包数
+#define FEC_XOR2D_MAX_PAYLOAD   (FEC_SHARD_SIZE - FEC_HEADER_SIZE - 2)
 
 // =========================================================
 // 统一 FEC 接口
@@ -39,32 +49,399 @@ fec_engine_t* fec_create(fec_type_t type, uint8_t data_shards, uint8_t parity_sh
 // 销毁
 void fec_destroy(fec_engine_t *engine);
 
+// 单次编码可接受的最大数据长度（随类型、ds 与 fec_reconfigure 变化）
+size_t fec_max_payload(const fec_engine_t *engine);
+
 // 编码
-// 返回分片总数，分片数据写入 out_shards
+// 返回分片总数，分片数据写入 out_shards；len 超过 fec_max_payload 时返回 -1
 int fec_encode(fec_engine_t *engine,
                const uint8_t *data, size_t len,
                uint8_t out_shards[][FEC_SHARD_SIZE],
                size_t out_lens[],
                uint32_t *group_id);
 
+// 零拷贝分散/聚集编码（仅 RS_SIMPLE / RS_SIMD）
+// data:   ds 个数据分片，直接指向调用方缓冲区（如接收缓冲区），
+//         长度可以不同，不足 shard_size 的部分按 0 参与计算
+// parity: ps 个调用方缓冲区，每个至少 FEC_HEADER_SIZE + shard_size 字节，
+//         写入分片头和校验数据，可直接发送
+// 数据分片不拷贝：用 fec_write_header() 生成头部，与数据一起 sendmsg()，
+// 短分片可直接按原长发送，接收端按 0 扩展
+// 返回校验分片数，输出 shard_size（不含头部，即最长数据分片的长度）；参数无效返回 -1
+int fec_encode_iov(fec_engine_t *engine,
+                   const struct iovec *data, int data_count,
+                   uint8_t *const parity[],
+                   size_t *shard_size,
+                   uint32_t *group_id);
+
+// 写入 FEC_HEADER_SIZE 字节的分片头（配合 fec_encode_iov 使用）
+void fec_write_header(fec_engine_t *engine, uint8_t *hdr,
+                      uint32_t group_id, uint8_t shard_idx, size_t shard_size);
+
+// 解析分片头，得到 fec_decode 所需的 group_id 与 shard_idx
+// 长度不足或版本不符返回 -1
+int fec_parse_header(const uint8_t *shard, size_t len,
+                     uint32_t *group_id, uint8_t *shard_idx);
+
 // 解码
 // 返回：0=等待更多分片, 1=恢复成功, -1=失败
+// 输出（及系统码模式的交付）按头部记录的精确负载长度去掉补齐
+// 已完成组的迟到分片直接丢弃，返回 0
 int fec_decode(fec_engine_t *engine,
                uint32_t group_id,
                uint8_t shard_idx,
                const uint8_t *shard_data, size_t shard_len,
                uint8_t *out_data, size_t *out_len);
 
-// 动态调整冗余率
+// 设置解码重组表槽位数（向上取 2 的幂），会丢弃正在重组的组
+// 只记录槽位数的引擎在第一次解码时按此创建重组表
+// 返回 0 成功，-1 内存不足（原表保持不变）
+int fec_set_decode_slots(fec_engine_t *engine, uint32_t slots);
+
+// 设置交付期限（默认 500 ms，从组的第一个分片到达算起，对正在重组的组
+// 同样生效）。到期仍未恢复的组被放弃：槽位与分片缓冲立即释放，计入
+// groups_abandoned，整组输出模式下已到达的数据分片交给 partial 回调，
+// 之后到达的分片按迟到丢弃。槽位不足时淘汰最早到达的组，处理相同
+void fec_set_group_timeout(fec_engine_t *engine, uint32_t timeout_ms);
+
+// 放弃所有已过期的组，返回放弃的组数。fec_decode 收到新组时会顺带检查，
+// 链路中断、没有新分片到达时由定时器调用（间隔取交付期限的一部分即可）
+int fec_decode_expire(fec_engine_t *engine);
+
+// 系统码接收模式
+// 数据分片到达即通过 deliver 交付，无需等待整组；只有数据分片确实丢失时
+// 才做矩阵恢复，恢复出的分片随后补交付。此模式下 fec_decode 不写 out_data，
+// 返回 1 表示该组已全部交付。deliver 传 NULL 恢复整组输出模式
+typedef void (*fec_deliver_fn)(void *user, uint32_t group_id, uint8_t shard_idx,
+                               const uint8_t *data, size_t len);
+void fec_set_systematic(fec_engine_t *engine, fec_deliver_fn deliver, void *user);
+
+// 整组输出模式下，被放弃的组把已到达的数据分片（按精确长度）逐个交给 fn，
+// 上层可按需使用残缺数据。系统码模式下数据分片到达即已交付，不再回调
+void fec_set_partial_handler(fec_engine_t *engine, fec_deliver_fn fn, void *user);
+
+// 二维 XOR 模式（FEC_TYPE_XOR_2D）
+// fec_create 的 data_shards = 行宽 L（2..FEC_XOR2D_MAX_WIDTH），parity_shards = 深度 D，
+// 块内分片数 L*D + L + D 不超过 FEC_MAX_TOTAL_SHARDS（超出时减小 D）。
+// 与滑动窗口相同，每次 fec_encode 编码一个源包（不超过 FEC_XOR2D_MAX_PAYLOAD），
+// 输出源分片，行满时附带行校验，块满时附带 L 个列校验；group_id 为块号。
+// 恢复出的源包通过 fec_set_systematic 的回调交付
+
+// 不补齐模式：数据分片按有效长度发送（out_lens 变短），末尾短分片
+// 只在校验运算中按 0 扩展；校验分片仍为完整 shard_size。接收端无需设置
+void fec_set_unpadded(fec_engine_t *engine, bool unpadded);
+
+// 滑动窗口模式（FEC_TYPE_SLIDING）
+// fec_create 的 data_shards = 修复间隔 N，parity_shards = 每次修复包数 R：
+// 每调用一次 fec_encode 编码一个源包（不超过 FEC_SLIDING_MAX_PAYLOAD），
+// 输出源分片，每第 N 个源包后再附带 R 个覆盖最近 W 个源包的修复分片。
+// group_id 为源包序号。解码端增量消元，恢复出的源包通过 fec_set_systematic
+// 的回调交付（shard_idx 为 0），未设置回调时 fec_decode 只输出收到的源包本身
+// 设置窗口 W（N <= W <= FEC_SLIDING_MAX_WINDOW，默认 4N），成功返回 0
+int fec_set_sliding_window(fec_engine_t *engine, uint8_t window);
+
+// =========================================================
+// 跨组交织（发送端）
+// =========================================================
+// fec_encode 逐组连续输出 ds + ps 个分片，一次长于 ps 的突发就会打穿一组。
+// 交织器缓冲 depth 组，按分片序号轮转发出，突发分摊到多组：同样的校验
+// 比例能扛住约 depth 倍长的突发。等待 depth 组的附加时延受 budget_us
+// 限制：最早一组等满预算即发出已缓冲的组（fec_interleaver_push 时检查，
+// 空闲时由定时器调用 fec_interleaver_poll）。
+// 适用于按组编码的类型（XOR / RS / Cauchy）；滑动窗口与二维 XOR 本身已
+// 把校验分散在源包之间，不必再交织。
+// 接收端无需设置：重组表按 group_id 哈希，多组同时重组（默认 64 槽，
+// 不少于 FEC_INTERLEAVE_MAX_DEPTH），分片乱序到达照常解码；
+// 组超时（fec_set_group_timeout）应大于交织预算
+#define FEC_INTERLEAVE_MAX_DEPTH    8
+
+typedef struct fec_interleaver_s fec_interleaver_t;
+
+// 发出一个分片（含 FEC 头）
+typedef void (*fec_send_fn)(void *user, const uint8_t *shard, size_t len);
+
+typedef struct {
+    uint64_t groups;            // 入队的组
+    uint64_t shards;            // 发出的分片
+    uint64_t full_rounds;       // 攒满 depth 组发出的轮次
+    uint64_t deadline_flushes;  // 因时延预算提前发出的轮次
+} fec_interleaver_stats_t;
+
+// depth 1..FEC_INTERLEAVE_MAX_DEPTH（1 = 不交织，直接转发）
+fec_interleaver_t* fec_interleaver_create(uint8_t depth, uint32_t budget_us,
+                                          fec_send_fn send, void *user);
+void fec_interleaver_destroy(fec_interleaver_t *ilv);
+
+// 提交 fec_encode 输出的一组分片（复制），返回本次发出的分片数，参数非法返回 -1
+int fec_interleaver_push(fec_interleaver_t *ilv,
+                         const uint8_t shards[][FEC_SHARD_SIZE],
+                         const size_t lens[], int count);
+
+// 最早一组超过预算时发出全部已缓冲的组，返回发出的分片数
+int fec_interleaver_poll(fec_interleaver_t *ilv);
+
+// 立即发出全部已缓冲的组（如连接关闭前）
+int fec_interleaver_flush(fec_interleaver_t *ilv);
+
+// 距下一次需要 poll 的微秒数（0 = 已到期，UINT32_MAX = 无缓冲），用于设定定时器
+uint32_t fec_interleaver_timeout_us(const fec_interleaver_t *ilv);
+
+void fec_interleaver_get_stats(const fec_interleaver_t *ilv, fec_interleaver_stats_t *stats);
+
+// =========================================================
+// 流式编码（发送端逐包）
+// =========================================================
+// fec_encode 要等整组负载凑齐才计算校验，先到的包跟着等待。流式编码器
+// 每收到一个包立即作为数据分片发出（不补齐），同时乘加进各校验行的
+// 累加器；凑满 ds 个包，或组开启超过 flush_us（fec_stream_push 时检查，
+// 空闲时由定时器调用 fec_stream_poll）时发出 ps 个校验分片。
+// 仅 RS_SIMPLE / RS_SIMD 引擎；ds:ps 在每组开始时取引擎当前值，
+// fec_reconfigure 选择的 XOR 组按单校验 RS 组发出。
+// 线上为带 STREAM 标志的 RS 分片：数据分片即原始包，校验分片只有组内
+// 最长包那么长，末尾附带各数据分片的长度表（提前结束的组未使用的分片
+// 长度为 0、不发送）。同类型的解码端直接支持，系统码模式下收到的和
+// 恢复出的包都按原长度交付，整组输出模式按顺序拼接各包
+#define FEC_STREAM_MAX_PAYLOAD  (FEC_SHARD_SIZE - FEC_HEADER_SIZE - 2 * FEC_MAX_DATA_SHARDS)
+
+typedef struct fec_stream_s fec_stream_t;
+
+typedef struct {
+    uint64_t groups;
+    uint64_t timer_closes;      // 未凑满 ds 个包、因时限提前结束的组
+    uint64_t data_shards;
+    uint64_t parity_shards;
+} fec_stream_stats_t;
+
+// 编码器使用 engine 的组号与内核，engine 须比编码器存活更久
+fec_stream_t* fec_stream_create(fec_engine_t *engine, uint32_t flush_us,
+                                fec_send_fn send, void *user);
+void fec_stream_destroy(fec_stream_t *stream);
+
+// 发出一个包（1..FEC_STREAM_MAX_PAYLOAD 字节），组满时随后发出校验，
+// 返回本次发出的分片数，参数非法返回 -1
+int fec_stream_push(fec_stream_t *stream, const uint8_t *data, size_t len);
+
+// 当前组超过时限时发出校验，返回发出的分片数
+int fec_stream_poll(fec_stream_t *stream);
+
+// 立即结束当前组（如连接关闭前）
+int fec_stream_flush(fec_stream_t *stream);
+
+// 距下一次需要 poll 的微秒数（0 = 已到期，UINT32_MAX = 无未结束的组）
+uint32_t fec_stream_timeout_us(const fec_stream_t *stream);
+
+void fec_stream_get_stats(const fec_stream_t *stream, fec_stream_stats_t *stats);
+
+// =========================================================
+// 批量编码（多线程）
+// =========================================================
+// 一次提交多个待编码组（可来自不同会话的引擎），由线程池并行编码。
+// 组号在调用线程上按提交顺序分配，结果按 items 顺序写回，
+// fec_encode_batch 返回时全部完成。RS 组并行编码；XOR/滑动窗口组
+// 有状态，在调用线程上按顺序编码。批处理期间不要对同一引擎调用
+// fec_encode / fec_set_loss_rate 等会修改引擎的接口
+typedef struct fec_pool_s fec_pool_t;
+
+typedef struct {
+    fec_engine_t *engine;
+    const uint8_t *data;
+    size_t        len;
+    uint8_t     (*out_shards)[FEC_SHARD_SIZE];  // 至少 FEC_MAX_TOTAL_SHARDS 个
+    size_t       *out_lens;
+    uint32_t      group_id;     // 输出
+    int           result;       // 输出：同 fec_encode 返回值
+} fec_batch_item_t;
+
+// threads <= 0 时按 CPU 数自动选择（调用线程也参与编码）
+fec_pool_t* fec_pool_create(int threads);
+void fec_pool_destroy(fec_pool_t *pool);
+int fec_pool_threads(const fec_pool_t *pool);
+
+// 返回处理的组数
+int fec_encode_batch(fec_pool_t *pool, fec_batch_item_t *items, int count);
+
+// 动态调整冗余率（只改校验分片数；fec_reconfigure 选择的 XOR 组保持不变）
 void fec_set_loss_rate(fec_engine_t *engine, float loss_rate);
 
+// 运行中修改分组参数（发送端，下一组生效）
+// RS 引擎：type 为引擎自身类型时改为 ds:ps；type 为 FEC_TYPE_XOR 时改以
+// ds 个数据分片 + 1 个 XOR 校验编码（忽略 parity_shards），同类型的 RS 引擎
+// 能直接解码两种组。XOR 引擎只能修改 ds（不超过 FEC_XOR_GROUP_SIZE）。
+// 其他类型或参数非法返回 -1
+int fec_reconfigure(fec_engine_t *engine, fec_type_t type,
+                    uint8_t data_shards, uint8_t parity_shards);
+
+// 解码端统计（累计值，滑动窗口模式不分组，恒为 0）
+typedef struct {
+    uint64_t groups_recovered;  // 有数据分片丢失但已恢复的组
+    uint64_t groups_failed;     // 未能恢复的组（放弃或解码失败）
+    uint64_t groups_abandoned;  // 其中超过交付期限或被淘汰而放弃的组
+    uint64_t shards_flushed;    // 放弃时交给 partial 回调的数据分片
+    uint64_t late_shards;       // 组完成或放弃后才到达、被丢弃的分片
+} fec_decode_stats_t;
+
+void fec_get_decode_stats(const fec_engine_t *engine, fec_decode_stats_t *stats);
+
+// 内存占用（单个引擎）
+// 解码状态在第一次 fec_decode 时创建；重组中的组按实际 (ds + ps) x shard_size
+// 从所有引擎共享的分片 slab 申请缓冲，组完成或被淘汰时归还
+typedef struct {
+    size_t   engine_bytes;      // 引擎本体与编码状态（编码矩阵、调度、滑动窗口等）
+    size_t   decoder_bytes;     // 重组表元数据与逆矩阵缓存，未解码过为 0
+    size_t   shard_bytes;       // 当前持有的分片缓冲（按 slab 对象大小计）
+    uint32_t groups_active;     // 正在重组的组数
+} fec_mem_stats_t;
+
+void fec_get_mem_stats(const fec_engine_t *engine, fec_mem_stats_t *stats);
+
+// 全局分片 slab
+// 总量达到上限后新组无法申请缓冲，fec_decode 返回 -1 并计入 alloc_failures。
+// 默认上限 128 MB，0 = 不限制；降低上限不回收已分配的页
+typedef struct {
+    size_t   limit;
+    size_t   reserved;          // 已向系统申请的页
+    size_t   in_use;            // 已分配给组的对象
+    size_t   peak;              // in_use 峰值
+    uint64_t alloc_failures;
+} fec_slab_stats_t;
+
+void fec_slab_set_limit(size_t bytes);
+void fec_slab_get_stats(fec_slab_stats_t *stats);
+
+// =========================================================
+// 自适应 FEC 控制器（每会话一个）
+// =========================================================
+// 发送端按窗口（如每秒）把接收端反馈的丢包统计交给 fec_ctrl_update，
+// 控制器选出 (类型, ds, ps)，返回 true 时用 fec_ctrl_apply 应用到编码引擎。
+// 提升保护立即生效，降低保护需连续 hold_windows 个窗口确认（滞回）；
+// 冗余占比 ps / (ds + ps) 不超过 max_overhead（带宽预算）。
+// 单校验时选 FEC_TYPE_XOR，否则选 base_type
+typedef struct {
+    uint32_t packets;           // 窗口内应收分片数
+    uint32_t lost;              // 丢失分片数
+    uint32_t bursts;            // 丢包突发次数（连续丢失记一次）
+    uint32_t groups_recovered;  // 有丢失但已恢复的组
+    uint32_t groups_failed;     // 未能恢复的组
+} fec_loss_window_t;
+
+typedef struct {
+    // 配置（fec_ctrl_init 填默认值，之后可直接修改）
+    fec_type_t  base_type;          // 多校验时使用的 RS 类型
+    float       max_overhead;       // 带宽预算：冗余占比上限
+    float       target_fail;        // 目标组失败率（默认 0.1%）
+    uint8_t     max_data_shards;    // 每组数据分片上限，限制恢复延迟（默认 10）
+    uint8_t     hold_windows;       // 降低保护前需连续确认的窗口数（默认 4）
+    
+    // 链路估计
+    float       loss_rate;          // 平滑丢包率
+    float       mean_burst;         // 平滑平均突发长度
+    float       margin;             // 闭环裕量，组恢复失败时放大
+    
+    // 当前决策
+    fec_type_t  type;
+    uint8_t     data_shards;
+    uint8_t     parity_shards;
+    
+    // 滞回状态
+    uint8_t     pending_ds;
+    uint8_t     pending_ps;
+    uint8_t     pending_windows;
+    
+    // 决策计数
+    uint64_t    windows;
+    uint64_t    raises;             // 提升保护
+    uint64_t    lowers;             // 降低保护
+    uint64_t    held;               // 因滞回或死区暂缓的调整
+    uint64_t    type_switches;      // XOR / RS 切换
+    uint64_t    budget_capped;      // 预算内达不到目标失败率
+    uint64_t    groups_recovered;
+    uint64_t    groups_failed;
+} fec_ctrl_t;
+
+// 初始决策为 base_type 5:2；max_overhead <= 0 时取 0.5
+void fec_ctrl_init(fec_ctrl_t *ctrl, fec_type_t base_type, float max_overhead);
+
+// 输入一个窗口的统计，决策改变时返回 true
+bool fec_ctrl_update(fec_ctrl_t *ctrl, const fec_loss_window_t *window);
+
+// 把当前决策应用到编码引擎，返回 fec_reconfigure 的结果
+int fec_ctrl_apply(const fec_ctrl_t *ctrl, fec_engine_t *engine);
+
 // 获取当前类型
 fec_type_t fec_get_type(fec_engine_t *engine);
 
+// 获取当前使用的 GF 乘法内核名称（如 "GFNI-AVX-512"、"Scalar"）
+const char* fec_get_kernel_name(fec_engine_t *engine);
+
 // CPU 能力检测
 bool fec_simd_available(void);
 
 // 性能测试
 double fec_benchmark(fec_type_t type, size_t data_size, int iterations);
 
+// 逐个测试本机可用的 SIMD 内核（NEON/SVE/AVX2/GFNI...）
+typedef struct {
+    const char *name;
+    double      mbps;
+} fec_kernel_result_t;
+
+// 返回写入 results 的条目数
+int fec_benchmark_kernels(size_t data_size, int iterations,
+                          fec_kernel_result_t *results, int max_results);
+
+// 逐行编码与列分块编码的对比（纯校验生成，data_size 为每组数据总量）
+typedef struct {
+    const char *name;
+    double      row_mbps;       // 每行校验完整扫一遍数据
+    double      blocked_mbps;   // 每个数据列块只读一次，累加全部校验行
+} fec_blocked_result_t;
+
+// 返回写入 results 的条目数，参数非法时返回 -1
+int fec_benchmark_blocked(uint8_t data_shards, uint8_t parity_shards,
+                          size_t data_size, int iterations,
+                          fec_blocked_result_t *results, int max_results);
+
+// 基准测试套件：每个实现（"Scalar" 查表、各可用 SIMD 内核、"Cauchy" 位矩阵）
+// 在每个 (ds, ps) 上测编码，以及丢 0..ps 个分片（随机位置 / 连续突发）的解码。
+// 每条结果通过 report 回调输出，返回结果条数，内存不足返回 -1
+typedef enum {
+    FEC_BENCH_ENCODE,
+    FEC_BENCH_DECODE,
+} fec_bench_op_t;
+
+typedef enum {
+    FEC_BENCH_LOSS_NONE,
+    FEC_BENCH_LOSS_RANDOM,      // 随机位置
+    FEC_BENCH_LOSS_BURST,       // 连续编号
+} fec_bench_pattern_t;
+
+typedef struct {
+    const char         *impl;
+    uint8_t             data_shards;
+    uint8_t             parity_shards;
+    size_t              shard_size;
+    fec_bench_op_t      op;
+    fec_bench_pattern_t pattern;        // 仅解码
+    uint8_t             lost;           // 仅解码：丢失分片数
+    int                 iterations;
+    double              mbps;           // 按数据字节计
+    double              cycles_per_byte;// x86-64 TSC 周期，其他平台为 0
+    double              p50_ns;         // 每次调用（整组）延迟
+    double              p99_ns;
+    bool                verified;       // 解码结果与原数据一致（编码行：从校验分片恢复）
+} fec_bench_result_t;
+
+typedef void (*fec_bench_report_fn)(void *user, const fec_bench_result_t *result);
+
+typedef struct {
+    const uint8_t (*grid)[2];   // (ds, ps) 列表，NULL 用默认 5:2、10:4、20:10
+    int         grid_count;
+    size_t      shard_size;     // 每分片字节（按 64 取整），0 = 1024
+    int         iterations;     // 每项调用次数，0 = 2000
+} fec_bench_config_t;
+
+int fec_benchmark_suite(const fec_bench_config_t *config,
+                        fec_bench_report_fn report, void *user);
+
+
 #endif // V3_FEC_SIMD_H
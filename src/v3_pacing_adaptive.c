@@ -9,6 +9,8 @@
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
+#define PACING_MSS              1400
+
 static inline uint64_t get_time_ns(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -24,6 +26,16 @@ static inline uint64_t xorshift64(pacing_adaptive_t *ctx) {
     return x;
 }
 
+// 取算法给出的发送速率（0 = 不改变），限制在设定范围内
+static void apply_cc_rate(pacing_adaptive_t *ctx) {
+    uint64_t rate = ctx->cc->pacing_rate ? ctx->cc->pacing_rate(ctx) : 0;
+    if (rate == 0) return;
+    
+    ctx->target_bps = MIN(rate, ctx->max_bps);
+    ctx->target_bps = MAX(ctx->target_bps, ctx->min_bps);
+    ctx->tokens_per_ns = (double)ctx->target_bps / 8.0 / 1e9;
+}
+
 void pacing_adaptive_init(pacing_adaptive_t *ctx, uint64_t initial_bps) {
     memset(ctx, 0, sizeof(*ctx));
     
@@ -43,6 +55,14 @@ void pacing_adaptive_init(pacing_adaptive_t *ctx, uint64_t initial_bps) {
     ctx->ssthresh = UINT64_MAX;
     
     ctx->rng_state = get_time_ns() ^ 0xDEADBEEF;
+    
+    ctx->cc = &pacing_cc_reno;
+}
+
+void pacing_adaptive_set_cc(pacing_adaptive_t *ctx, const pacing_cc_ops_t *ops) {
+    ctx->cc = ops;
+    ctx->model_enabled = false;
+    if (ops->init) ops->init(ctx);
 }
 
 void pacing_adaptive_set_range(pacing_adaptive_t *ctx, 
@@ -66,13 +86,16 @@ void pacing_adaptive_update_rtt(pacing_adaptive_t *ctx, uint64_t rtt_us) {
         ctx->rtt_var = ctx->rtt_var * 0.75 + (diff > 0 ? diff : -diff) * 0.25;
         ctx->rtt_us = ctx->rtt_us * 0.875 + rtt_us * 0.125;
     }
+    // 本机回环等场景样本可为 0，EWMA 截断后也会落到 0；速率计算要除以它
+    if (ctx->rtt_us == 0) ctx->rtt_us = 1;
     
     if (rtt_us < ctx->rtt_min_us) ctx->rtt_min_us = rtt_us;
     if (rtt_us > ctx->rtt_max_us) ctx->rtt_max_us = rtt_us;
     
-    // 更新带宽估计（BBR 风格）
+    // 带宽估计（pacing_adaptive_get_bw）对所有算法都更新；
+    // 模型模式的带宽来自投递速率采样
     // BW = bytes_in_flight / RTT
-    if (ctx->bytes_in_flight > 0 && rtt_us > 0) {
+    if (!ctx->model_enabled && ctx->bytes_in_flight > 0 && rtt_us > 0) {
         uint64_t bw = ctx->bytes_in_flight * 8 * 1000000 / rtt_us;
         
         // EWMA
@@ -81,12 +104,10 @@ void pacing_adaptive_update_rtt(pacing_adaptive_t *ctx, uint64_t rtt_us) {
         } else {
             ctx->bw_estimate_bps = ctx->bw_estimate_bps * 0.9 + bw * 0.1;
         }
-        
-        // 调整发送速率
-        ctx->target_bps = MIN(ctx->bw_estimate_bps, ctx->max_bps);
-        ctx->target_bps = MAX(ctx->target_bps, ctx->min_bps);
-        ctx->tokens_per_ns = (double)ctx->target_bps / 8.0 / 1e9;
     }
+    
+    if (ctx->cc->on_rtt) ctx->cc->on_rtt(ctx, rtt_us);
+    apply_cc_rate(ctx);
 }
 
 void pacing_adaptive_report_loss(pacing_adaptive_t *ctx) {
@@ -99,32 +120,8 @@ void pacing_adaptive_report_loss(pacing_adaptive_t *ctx) {
     }
     ctx->last_loss_ns = now;
     
-    switch (ctx->state) {
-    case PACING_SLOW_START:
-        // 退出慢启动
-        ctx->ssthresh = ctx->cwnd / 2;
-        ctx->cwnd = ctx->ssthresh;
-        ctx->state = PACING_RECOVERY;
-        break;
-        
-    case PACING_CONGESTION_AVOIDANCE:
-        // 乘性减少
-        ctx->ssthresh = ctx->cwnd / 2;
-        ctx->cwnd = ctx->ssthresh;
-        ctx->state = PACING_RECOVERY;
-        break;
-        
-    case PACING_RECOVERY:
-        // 已经在恢复中，不再减少
-        break;
-    }
-    
-    // 降低发送速率
-    ctx->target_bps = ctx->target_bps * 7 / 10;  // 降到 70%
-    if (ctx->target_bps < ctx->min_bps) {
-        ctx->target_bps = ctx->min_bps;
-    }
-    ctx->tokens_per_ns = (double)ctx->target_bps / 8.0 / 1e9;
+    if (ctx->cc->on_loss) ctx->cc->on_loss(ctx);
+    apply_cc_rate(ctx);
 }
 
 static void refill_tokens(pacing_adaptive_t *ctx, uint64_t now_ns) {
@@ -135,6 +132,15 @@ static void refill_tokens(pacing_adaptive_t *ctx, uint64_t now_ns) {
     double max_burst = ctx->target_bps / 8.0 * ctx->rtt_us / 1e6;
     if (max_burst < 65536) max_burst = 65536;
     
+    // 速率由算法给出的（cubic / bbr）严格按速率发送：突发不超过约 1ms 的
+    // 数据量（2 个包 .. 64KB），否则被窗口限制时积攒的令牌一次发出，
+    // 在瓶颈处形成队列（HyStart++ 也会被突发造成的 RTT 起伏误导）
+    if (ctx->cc->strict_pacing) {
+        max_burst = ctx->target_bps / 8.0 / 1000;
+        max_burst = MAX(max_burst, 2 * 1400);
+        max_burst = MIN(max_burst, 65536);
+    }
+    
     ctx->tokens += new_tokens;
     if (ctx->tokens > max_burst) {
         ctx->tokens = max_burst;
@@ -192,6 +198,68 @@ void pacing_adaptive_ack(pacing_adaptive_t *ctx, size_t bytes) {
         ctx->bytes_in_flight -= bytes;
     }
     
+    if (ctx->cc->on_ack) ctx->cc->on_ack(ctx, bytes);
+    apply_cc_rate(ctx);
+}
+
+uint64_t pacing_adaptive_get_bw(pacing_adaptive_t *ctx) {
+    return ctx->bw_estimate_bps;
+}
+
+bool pacing_adaptive_allow_burst(pacing_adaptive_t *ctx, size_t bytes) {
+    // 允许短暂突发：
+    // 1. 在慢启动阶段
+    // 2. 令牌足够
+    // 3. 拥塞窗口足够
+    
+    bool starting = ctx->model_enabled ? ctx->model.phase == PACING_BBR_STARTUP
+                                       : ctx->state == PACING_SLOW_START;
+    if (starting) {
+        return ctx->bytes_in_flight + bytes <= ctx->cwnd;
+    }
+    
+    // 其他状态下，允许最多 2 个 MSS 的突发
+    return bytes <= 2 * 1400 && ctx->tokens >= bytes;
+}
+
+// =========================================================
+// Reno（默认）
+// =========================================================
+// 慢启动按确认量翻倍，拥塞避免每 RTT 加 1 个包，丢包减半；
+// 速率跟随 在途字节 / RTT 的平滑估计，丢包时降到 70%
+static void reno_on_rtt(pacing_adaptive_t *ctx, uint64_t rtt_us) {
+    // 跟随 pacing_adaptive_update_rtt 刚更新的带宽估计
+    if (ctx->bytes_in_flight > 0 && rtt_us > 0) {
+        ctx->reno_rate_bps = ctx->bw_estimate_bps;
+    }
+}
+
+static void reno_on_loss(pacing_adaptive_t *ctx) {
+    switch (ctx->state) {
+    case PACING_SLOW_START:
+        // 退出慢启动
+        ctx->ssthresh = ctx->cwnd / 2;
+        ctx->cwnd = ctx->ssthresh;
+        ctx->state = PACING_RECOVERY;
+        break;
+        
+    case PACING_CONGESTION_AVOIDANCE:
+        // 乘性减少
+        ctx->ssthresh = ctx->cwnd / 2;
+        ctx->cwnd = ctx->ssthresh;
+        ctx->state = PACING_RECOVERY;
+        break;
+        
+    case PACING_RECOVERY:
+        // 已经在恢复中，不再减少
+        break;
+    }
+    
+    // 降低发送速率
+    ctx->reno_rate_bps = ctx->target_bps * 7 / 10;  // 降到 70%
+}
+
+static void reno_on_ack(pacing_adaptive_t *ctx, size_t bytes) {
     // 拥塞窗口增长
     switch (ctx->state) {
     case PACING_SLOW_START:
@@ -216,20 +284,453 @@ void pacing_adaptive_ack(pacing_adaptive_t *ctx, size_t bytes) {
     }
 }
 
-uint64_t pacing_adaptive_get_bw(pacing_adaptive_t *ctx) {
-    return ctx->bw_estimate_bps;
+static uint64_t reno_pacing_rate(pacing_adaptive_t *ctx) {
+    return ctx->reno_rate_bps;
 }
 
-bool pacing_adaptive_allow_burst(pacing_adaptive_t *ctx, size_t bytes) {
-    // 允许短暂突发：
-    // 1. 在慢启动阶段
-    // 2. 令牌足够
-    // 3. 拥塞窗口足够
+const pacing_cc_ops_t pacing_cc_reno = {
+    .name          = "reno",
+    .strict_pacing = false,     // 速率跟随带宽估计，保留 1 个 RTT 的突发
+    .on_ack        = reno_on_ack,
+    .on_loss       = reno_on_loss,
+    .on_rtt        = reno_on_rtt,
+    .pacing_rate   = reno_pacing_rate,
+};
+
+// =========================================================
+// CUBIC + HyStart++
+// =========================================================
+// 拥塞避免期窗口按 W(t) = C (t - K)^3 + W_max 增长（t 为距上次降窗的秒数，
+// 单位为包）：远离 W_max 时快速增长，接近时放缓，增长与 RTT 无关。
+// 1 Gbps x 200ms 丢包一次后，Reno 每 RTT 加 1 个包要几十分钟才能恢复，
+// CUBIC 约 K = cbrt(W_max (1 - beta) / C) 秒。低 BDP 时取 Reno 友好估计，不比 Reno 慢。
+// 慢启动用 HyStart++：一轮的最小 RTT 比上一轮高出 clamp(上一轮 / 8, 4ms, 16ms)
+// 即进入保守慢启动（增长 1/4），再持续 5 轮转入拥塞避免；期间 RTT 回落
+// 视为误判，恢复慢启动。在排队刚开始时退出，避免冲过头造成成批丢包
+#define CUBIC_C                     0.4     // 包 / 秒^3
+#define CUBIC_BETA                  0.7
+#define HYSTART_MIN_RTT_THRESH_US   4000
+#define HYSTART_MAX_RTT_THRESH_US   16000
+#define HYSTART_N_RTT_SAMPLE        8
+#define HYSTART_CSS_GROWTH_DIVISOR  4
+#define HYSTART_CSS_ROUNDS          5
+
+// 立方根（牛顿迭代，从上方收敛，不依赖 libm）
+static double cubic_cbrt(double x) {
+    if (x <= 0) return 0;
+    double y = 1.0;
+    while (y * y * y < x) y *= 2;
+    for (int i = 0; i < 20; i++) y = (2 * y + x / (y * y)) / 3;
+    return y;
+}
+
+// W(t)（字节）
+static double cubic_window(const pacing_cubic_t *c, double t) {
+    double d = t - c->k;
+    return (CUBIC_C * d * d * d) * PACING_MSS + (double)c->w_max;
+}
+
+static void cubic_init(pacing_adaptive_t *ctx) {
+    pacing_cubic_t *c = &ctx->cubic;
+    memset(c, 0, sizeof(*c));
+    
+    c->acked = ctx->total_bytes - ctx->bytes_in_flight;
+    c->round_end = ctx->total_bytes;
+    c->last_round_min_rtt_us = UINT64_MAX;
+    c->round_min_rtt_us = UINT64_MAX;
+    if (ctx->state == PACING_RECOVERY) ctx->state = PACING_CONGESTION_AVOIDANCE;
+}
+
+static void cubic_on_rtt(pacing_adaptive_t *ctx, uint64_t rtt_us) {
+    pacing_cubic_t *c = &ctx->cubic;
+    if (ctx->state != PACING_SLOW_START) return;
+    
+    if (rtt_us < c->round_min_rtt_us) c->round_min_rtt_us = rtt_us;
+    c->rtt_samples++;
+    if (c->rtt_samples < HYSTART_N_RTT_SAMPLE || c->last_round_min_rtt_us == UINT64_MAX) return;
+    
+    if (!c->css) {
+        uint64_t thresh = c->last_round_min_rtt_us / 8;
+        thresh = MAX(thresh, HYSTART_MIN_RTT_THRESH_US);
+        thresh = MIN(thresh, HYSTART_MAX_RTT_THRESH_US);
+        if (c->round_min_rtt_us >= c->last_round_min_rtt_us + thresh) {
+            c->css = true;
+            c->css_rounds = 0;
+            c->css_baseline_rtt_us = c->round_min_rtt_us;
+        }
+    } else if (c->round_min_rtt_us < c->css_baseline_rtt_us) {
+        c->css = false;
+    }
+}
+
+static void cubic_on_ack(pacing_adaptive_t *ctx, size_t bytes) {
+    pacing_cubic_t *c = &ctx->cubic;
+    
+    // 往返轮次：本轮开始时已发出的字节全部确认即开始新一轮
+    bool round_start = false;
+    c->acked += bytes;
+    if (c->acked >= c->round_end) {
+        c->round_end = ctx->total_bytes;
+        c->last_round_min_rtt_us = c->round_min_rtt_us;
+        c->round_min_rtt_us = UINT64_MAX;
+        c->rtt_samples = 0;
+        round_start = true;
+    }
     
     if (ctx->state == PACING_SLOW_START) {
-        return ctx->bytes_in_flight + bytes <= ctx->cwnd;
+        if (c->css) {
+            ctx->cwnd += bytes / HYSTART_CSS_GROWTH_DIVISOR;
+            if (round_start && ++c->css_rounds >= HYSTART_CSS_ROUNDS) ctx->ssthresh = ctx->cwnd;
+        } else {
+            ctx->cwnd += bytes;
+        }
+        if (ctx->cwnd >= ctx->ssthresh) ctx->state = PACING_CONGESTION_AVOIDANCE;
+        return;
     }
     
-    // 其他状态下，允许最多 2 个 MSS 的突发
-    return bytes <= 2 * 1400 && ctx->tokens >= bytes;
+    uint64_t now = get_time_ns();
+    if (c->epoch_start_ns == 0) {
+        c->epoch_start_ns = now;
+        c->w_est = ctx->cwnd;
+        if (c->w_max > ctx->cwnd) {
+            c->k = cubic_cbrt((double)(c->w_max - ctx->cwnd) / PACING_MSS / CUBIC_C);
+        } else {
+            c->k = 0;
+            c->w_max = ctx->cwnd;
+        }
+    }
+    
+    // 目标取一个 RTT 之后的 W，每个 RTT 至多增长 50%
+    double t = (now - c->epoch_start_ns) / 1e9;
+    double target = cubic_window(c, t + ctx->rtt_us / 1e6);
+    target = MAX(target, (double)ctx->cwnd);
+    target = MIN(target, ctx->cwnd * 1.5);
+    
+    // Reno 友好估计：与 Reno 在同样丢包率下的平均窗口一致
+    double alpha = c->w_est >= c->w_max ? 1.0 : 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA);
+    c->w_est += alpha * PACING_MSS * bytes / ctx->cwnd;
+    
+    if (cubic_window(c, t) < c->w_est) {
+        ctx->cwnd = MAX(ctx->cwnd, (uint64_t)c->w_est);
+    } else {
+        ctx->cwnd += (uint64_t)((target - ctx->cwnd) * bytes / ctx->cwnd);
+    }
+}
+
+static void cubic_on_loss(pacing_adaptive_t *ctx) {
+    pacing_cubic_t *c = &ctx->cubic;
+    
+    // 快速收敛：没回到上次的 W_max 就再次丢包，说明有新流加入，进一步让出带宽
+    if (ctx->cwnd < c->w_max) {
+        c->w_max = ctx->cwnd * (1 + CUBIC_BETA) / 2;
+    } else {
+        c->w_max = ctx->cwnd;
+    }
+    
+    ctx->ssthresh = MAX((uint64_t)(ctx->cwnd * CUBIC_BETA), 2 * PACING_MSS);
+    ctx->cwnd = ctx->ssthresh;
+    ctx->state = PACING_CONGESTION_AVOIDANCE;
+    c->epoch_start_ns = 0;
+    c->css = false;
+}
+
+// 窗口 / 平滑 RTT，慢启动 2 倍、拥塞避免 1.2 倍，确认间隙不至于让窗口闲置
+static uint64_t cubic_pacing_rate(pacing_adaptive_t *ctx) {
+    double gain = ctx->state == PACING_SLOW_START ? 2.0 : 1.2;
+    return (uint64_t)(ctx->cwnd * 8.0 * 1e6 / ctx->rtt_us * gain);
+}
+
+const pacing_cc_ops_t pacing_cc_cubic = {
+    .name          = "cubic",
+    .strict_pacing = true,
+    .init          = cubic_init,
+    .on_ack        = cubic_on_ack,
+    .on_loss       = cubic_on_loss,
+    .on_rtt        = cubic_on_rtt,
+    .pacing_rate   = cubic_pacing_rate,
+};
+
+// =========================================================
+// 模型模式（BBR 式）
+// =========================================================
+// 投递速率：两次确认之间新确认的字节 / 经过的时间，区间取发送侧与
+// 确认侧中较长者，避免 ACK 压缩把速率算高；短于最小 RTT 的区间丢弃。
+// 最大带宽滤波按往返轮次取窗口内最大值，最小 RTT 滤波按 10 秒窗口。
+// 相位：
+//   STARTUP    增益 2/ln2，每轮带宽翻倍，连续 3 轮增长不足 25% 即管道已满
+//   DRAIN      增益 ln2/2，排空 STARTUP 留下的队列，在途降到 BDP 后进入 PROBE_BW
+//   PROBE_BW   增益按 1.25, 0.75, 1 x 6 循环，每段约一个最小 RTT：
+//              1.25 探测更多带宽，0.75 排空探测造成的队列
+//   PROBE_RTT  最小 RTT 过期时窗口降到 4 个包，保持 200ms 且至少一轮，重新测最小 RTT
+#define PACING_BBR_HIGH_GAIN    2.885   // 2 / ln2
+#define PACING_BBR_MIN_CWND     (4 * PACING_MSS)
+#define PACING_BBR_MIN_RTT_NS   10000000000ULL
+#define PACING_BBR_PROBE_RTT_NS 200000000ULL
+#define PACING_BBR_CYCLE_LEN    8
+
+static const double bbr_cycle_gain[PACING_BBR_CYCLE_LEN] = {
+    1.25, 0.75, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0,
+};
+
+static void bbr_init(pacing_adaptive_t *ctx) {
+    pacing_model_t *m = &ctx->model;
+    memset(m, 0, sizeof(*m));
+    
+    m->phase = PACING_BBR_STARTUP;
+    m->pacing_gain = PACING_BBR_HIGH_GAIN;
+    m->cwnd_gain = PACING_BBR_HIGH_GAIN;
+    m->min_rtt_us = UINT64_MAX;
+    m->min_rtt_stamp_ns = get_time_ns();
+    
+    ctx->model_enabled = true;
+}
+
+// 按增益计算的 BDP（字节）；尚无带宽或 RTT 样本时取初始窗口
+static uint64_t bbr_bdp(const pacing_adaptive_t *ctx, double gain) {
+    const pacing_model_t *m = &ctx->model;
+    if (m->max_bw_bps == 0 || m->min_rtt_us == UINT64_MAX) return 10 * PACING_MSS;
+    return (uint64_t)(m->max_bw_bps / 8.0 * m->min_rtt_us / 1e6 * gain);
+}
+
+static void bbr_update_bw(pacing_adaptive_t *ctx, uint64_t bw) {
+    pacing_model_t *m = &ctx->model;
+    int slot = m->round_count % PACING_BBR_BW_ROUNDS;
+    
+    if (m->bw_round_id[slot] != m->round_count) {
+        m->bw_round_id[slot] = m->round_count;
+        m->bw_round_max[slot] = bw;
+    } else if (bw > m->bw_round_max[slot]) {
+        m->bw_round_max[slot] = bw;
+    }
+    
+    m->max_bw_bps = 0;
+    for (int i = 0; i < PACING_BBR_BW_ROUNDS; i++) {
+        if (m->bw_round_id[i] + PACING_BBR_BW_ROUNDS > m->round_count &&
+            m->bw_round_max[i] > m->max_bw_bps) {
+            m->max_bw_bps = m->bw_round_max[i];
+        }
+    }
+    ctx->bw_estimate_bps = m->max_bw_bps;
+}
+
+static void bbr_advance_cycle(pacing_model_t *m, uint64_t now) {
+    m->cycle_index = (m->cycle_index + 1) % PACING_BBR_CYCLE_LEN;
+    m->cycle_stamp_ns = now;
+    m->pacing_gain = bbr_cycle_gain[m->cycle_index];
+    m->loss_in_cycle = false;
+}
+
+// 随机从非 0.75 段开始，多条流的探测错开
+static void bbr_enter_probe_bw(pacing_adaptive_t *ctx, uint64_t now) {
+    pacing_model_t *m = &ctx->model;
+    m->phase = PACING_BBR_PROBE_BW;
+    m->cwnd_gain = 2.0;
+    m->cycle_index = PACING_BBR_CYCLE_LEN - 1 - xorshift64(ctx) % (PACING_BBR_CYCLE_LEN - 1);
+    bbr_advance_cycle(m, now);
+}
+
+static void bbr_update_phase(pacing_adaptive_t *ctx, const pacing_packet_t *pkt,
+                             bool round_start, bool min_rtt_expired, uint64_t now) {
+    pacing_model_t *m = &ctx->model;
+    uint64_t inflight = ctx->bytes_in_flight;
+    
+    // 满管检测
+    if (!m->filled_pipe && round_start && !pkt->app_limited) {
+        if (m->max_bw_bps >= m->full_bw_bps * 5 / 4) {
+            m->full_bw_bps = m->max_bw_bps;
+            m->full_bw_count = 0;
+        } else if (++m->full_bw_count >= 3) {
+            m->filled_pipe = true;
+        }
+    }
+    
+    switch (m->phase) {
+    case PACING_BBR_STARTUP:
+        if (m->filled_pipe) {
+            m->phase = PACING_BBR_DRAIN;
+            m->pacing_gain = 1.0 / PACING_BBR_HIGH_GAIN;
+            m->cwnd_gain = PACING_BBR_HIGH_GAIN;
+        }
+        break;
+        
+    case PACING_BBR_DRAIN:
+        if (inflight <= bbr_bdp(ctx, 1.0)) bbr_enter_probe_bw(ctx, now);
+        break;
+        
+    case PACING_BBR_PROBE_BW: {
+        bool full_length = now - m->cycle_stamp_ns > m->min_rtt_us * 1000;
+        bool next;
+        if (m->pacing_gain > 1.0) {
+            next = full_length && (m->loss_in_cycle || inflight >= bbr_bdp(ctx, m->pacing_gain));
+        } else if (m->pacing_gain < 1.0) {
+            next = full_length || inflight <= bbr_bdp(ctx, 1.0);
+        } else {
+            next = full_length;
+        }
+        if (next) bbr_advance_cycle(m, now);
+        break;
+    }
+        
+    case PACING_BBR_PROBE_RTT:
+        break;
+    }
+    
+    // PROBE_RTT
+    if (m->phase != PACING_BBR_PROBE_RTT && min_rtt_expired) {
+        m->phase = PACING_BBR_PROBE_RTT;
+        m->pacing_gain = 1.0;
+        m->cwnd_gain = 1.0;
+        m->prior_cwnd = ctx->cwnd;
+        m->probe_rtt_done_ns = 0;
+    }
+    if (m->phase == PACING_BBR_PROBE_RTT) {
+        if (m->probe_rtt_done_ns == 0 && inflight <= PACING_BBR_MIN_CWND) {
+            m->probe_rtt_done_ns = now + PACING_BBR_PROBE_RTT_NS;
+            m->probe_rtt_round_done = false;
+            m->next_round_delivered = m->delivered;
+        } else if (m->probe_rtt_done_ns) {
+            if (round_start) m->probe_rtt_round_done = true;
+            if (m->probe_rtt_round_done && now >= m->probe_rtt_done_ns) {
+                m->min_rtt_stamp_ns = now;
+                ctx->cwnd = MAX(ctx->cwnd, m->prior_cwnd);
+                if (m->filled_pipe) {
+                    bbr_enter_probe_bw(ctx, now);
+                } else {
+                    m->phase = PACING_BBR_STARTUP;
+                    m->pacing_gain = PACING_BBR_HIGH_GAIN;
+                    m->cwnd_gain = PACING_BBR_HIGH_GAIN;
+                }
+            }
+        }
+    }
+}
+
+// 窗口 = cwnd_gain x BDP + 3 个包（容纳 ACK 聚合）；管道未满前按确认量增长
+static void bbr_update_cwnd(pacing_adaptive_t *ctx, size_t acked) {
+    pacing_model_t *m = &ctx->model;
+    uint64_t target = bbr_bdp(ctx, m->cwnd_gain) + 3 * PACING_MSS;
+    
+    if (m->filled_pipe) {
+        ctx->cwnd = MIN(ctx->cwnd + acked, target);
+    } else if (ctx->cwnd < target || m->delivered < 10 * PACING_MSS) {
+        ctx->cwnd += acked;
+    }
+    ctx->cwnd = MAX(ctx->cwnd, PACING_BBR_MIN_CWND);
+    if (m->phase == PACING_BBR_PROBE_RTT) ctx->cwnd = MIN(ctx->cwnd, PACING_BBR_MIN_CWND);
+}
+
+// 发送速率 = pacing_gain x 最大带宽；STARTUP 阶段只升不降
+static uint64_t bbr_pacing_rate(pacing_adaptive_t *ctx) {
+    pacing_model_t *m = &ctx->model;
+    if (m->max_bw_bps == 0) return 0;
+    
+    uint64_t rate = (uint64_t)(m->max_bw_bps * m->pacing_gain);
+    if (!m->filled_pipe && rate < ctx->target_bps) return 0;
+    return rate;
+}
+
+// 模型不因单次丢包降速，只结束当前的带宽探测
+static void bbr_on_loss(pacing_adaptive_t *ctx) {
+    ctx->model.loss_in_cycle = true;
+}
+
+const pacing_cc_ops_t pacing_cc_bbr = {
+    .name          = "bbr",
+    .strict_pacing = true,
+    .init          = bbr_init,
+    .on_loss       = bbr_on_loss,
+    .pacing_rate   = bbr_pacing_rate,
+};
+
+void pacing_adaptive_enable_model(pacing_adaptive_t *ctx) {
+    pacing_adaptive_set_cc(ctx, &pacing_cc_bbr);
+}
+
+void pacing_adaptive_on_send(pacing_adaptive_t *ctx, pacing_packet_t *pkt, size_t bytes) {
+    pacing_model_t *m = &ctx->model;
+    uint64_t now = get_time_ns();
+    
+    // 空闲后的第一个包重新开始采样区间
+    if (ctx->bytes_in_flight == 0) {
+        m->first_sent_ns = now;
+        m->delivered_ns = now;
+    }
+    
+    pkt->sent_ns = now;
+    pkt->delivered = m->delivered;
+    pkt->delivered_ns = m->delivered_ns;
+    pkt->first_sent_ns = m->first_sent_ns;
+    pkt->bytes = bytes;
+    pkt->app_limited = m->app_limited != 0;
+    
+    pacing_adaptive_commit(ctx, bytes);
+}
+
+void pacing_adaptive_on_ack_packet(pacing_adaptive_t *ctx, const pacing_packet_t *pkt) {
+    pacing_model_t *m = &ctx->model;
+    uint64_t now = get_time_ns();
+    
+    if (pkt->bytes > ctx->bytes_in_flight) {
+        ctx->bytes_in_flight = 0;
+    } else {
+        ctx->bytes_in_flight -= pkt->bytes;
+    }
+    m->delivered += pkt->bytes;
+    m->delivered_ns = now;
+    
+    // RTT 与最小 RTT 滤波
+    uint64_t rtt_us = (now - pkt->sent_ns) / 1000;
+    if (rtt_us == 0) rtt_us = 1;
+    pacing_adaptive_update_rtt(ctx, rtt_us);
+    
+    bool min_rtt_expired = now - m->min_rtt_stamp_ns > PACING_BBR_MIN_RTT_NS;
+    if (rtt_us <= m->min_rtt_us || min_rtt_expired) {
+        m->min_rtt_us = rtt_us;
+        m->min_rtt_stamp_ns = now;
+    }
+    
+    // 往返轮次：本轮起点之后发出的包被确认即开始新一轮
+    bool round_start = false;
+    if (pkt->delivered >= m->next_round_delivered) {
+        m->next_round_delivered = m->delivered;
+        m->round_count++;
+        round_start = true;
+    }
+    
+    // 投递速率采样
+    uint64_t send_elapsed = pkt->sent_ns - pkt->first_sent_ns;
+    uint64_t ack_elapsed = now - pkt->delivered_ns;
+    uint64_t interval = MAX(send_elapsed, ack_elapsed);
+    m->first_sent_ns = pkt->sent_ns;
+    
+    if (interval > 0 && interval >= m->min_rtt_us * 1000) {
+        uint64_t bw = (uint64_t)((double)(m->delivered - pkt->delivered) * 8e9 / interval);
+        if (!pkt->app_limited || bw >= m->max_bw_bps) bbr_update_bw(ctx, bw);
+    }
+    if (m->app_limited && m->delivered > m->app_limited) m->app_limited = 0;
+    
+    bbr_update_phase(ctx, pkt, round_start, min_rtt_expired, now);
+    bbr_update_cwnd(ctx, pkt->bytes);
+    apply_cc_rate(ctx);
+}
+
+void pacing_adaptive_on_app_limited(pacing_adaptive_t *ctx) {
+    uint64_t mark = ctx->model.delivered + ctx->bytes_in_flight;
+    ctx->model.app_limited = mark ? mark : 1;
+}
+
+// =========================================================
+// 算法选择
+// =========================================================
+static const pacing_cc_ops_t *const pacing_cc_all[] = {
+    &pacing_cc_reno,
+    &pacing_cc_cubic,
+    &pacing_cc_bbr,
+};
+
+const pacing_cc_ops_t* pacing_cc_find(const char *name) {
+    for (size_t i = 0; i < sizeof(pacing_cc_all) / sizeof(pacing_cc_all[0]); i++) {
+        if (strcmp(pacing_cc_all[i]->name, name) == 0) return pacing_cc_all[i];
+    }
+    return NULL;
 }
@@ -12,7 +12,112 @@
 // =========================================================
 // 自适应 Pacing
 // =========================================================
+// 拥塞控制算法通过 pacing_cc_ops_t 选择（pacing_adaptive_set_cc，每个会话独立）：
+//   reno   默认：Reno 式拥塞窗口，带宽按 在途字节 / RTT 粗略估计
+//   cubic  CUBIC 窗口增长 + HyStart++ 慢启动退出，速率 = 窗口 / 平滑 RTT
+//          （命令行 --cc 默认选它）
+//   bbr    模型模式（pacing_adaptive_enable_model）：BBR 式，逐包投递速率采样，
+//          窗口内最大带宽 + 最小 RTT 建模，速率与窗口都由模型给出，
+//          在高 BDP 链路上跑满带宽而不堆积队列
+#define PACING_BBR_BW_ROUNDS    10      // 最大带宽滤波窗口（往返轮次）
+
+// 模型模式下每个包发送时的快照，由调用方随包保存，确认时交回
 typedef struct {
+    uint64_t    sent_ns;
+    uint64_t    delivered;          // 发送时的累计确认字节
+    uint64_t    delivered_ns;       // 发送时最近一次确认的时间
+    uint64_t    first_sent_ns;      // 发送时采样区间起点
+    uint32_t    bytes;
+    bool        app_limited;
+} pacing_packet_t;
+
+// BBR 式模型状态
+typedef struct {
+    enum {
+        PACING_BBR_STARTUP,
+        PACING_BBR_DRAIN,
+        PACING_BBR_PROBE_BW,
+        PACING_BBR_PROBE_RTT,
+    } phase;
+    double      pacing_gain;
+    double      cwnd_gain;
+    
+    // 投递速率采样
+    uint64_t    delivered;          // 累计确认字节
+    uint64_t    delivered_ns;
+    uint64_t    first_sent_ns;
+    uint64_t    app_limited;        // 非 0：累计确认越过该值之前的采样受应用限制
+    
+    // 往返轮次
+    uint64_t    round_count;
+    uint64_t    next_round_delivered;
+    
+    // 最大带宽滤波：最近 PACING_BBR_BW_ROUNDS 轮每轮的最大采样
+    uint64_t    bw_round_max[PACING_BBR_BW_ROUNDS];
+    uint64_t    bw_round_id[PACING_BBR_BW_ROUNDS];
+    uint64_t    max_bw_bps;
+    
+    // 最小 RTT 滤波（10 秒窗口，过期时进入 PROBE_RTT 重新测量）
+    uint64_t    min_rtt_us;
+    uint64_t    min_rtt_stamp_ns;
+    
+    // STARTUP：带宽连续 3 轮增长不足 25% 视为管道已满
+    uint64_t    full_bw_bps;
+    uint32_t    full_bw_count;
+    bool        filled_pipe;
+    
+    // PROBE_BW 增益循环
+    uint32_t    cycle_index;
+    uint64_t    cycle_stamp_ns;
+    bool        loss_in_cycle;
+    
+    // PROBE_RTT
+    uint64_t    probe_rtt_done_ns;
+    bool        probe_rtt_round_done;
+    uint64_t    prior_cwnd;
+} pacing_model_t;
+
+// CUBIC（RFC 9438）+ HyStart++（RFC 9406）状态
+typedef struct {
+    uint64_t    w_max;              // 上次降窗前的窗口（字节）
+    uint64_t    epoch_start_ns;     // 本段拥塞避免的起点，0 = 尚未开始
+    double      k;                  // 从起点回到 w_max 所需的秒数
+    double      w_est;              // Reno 友好窗口估计（字节）
+    
+    // HyStart++：逐轮比较最小 RTT
+    uint64_t    acked;              // 累计确认字节
+    uint64_t    round_end;          // 累计确认越过该值即开始新一轮
+    uint64_t    last_round_min_rtt_us;
+    uint64_t    round_min_rtt_us;
+    uint32_t    rtt_samples;
+    bool        css;                // 保守慢启动
+    uint32_t    css_rounds;
+    uint64_t    css_baseline_rtt_us;
+} pacing_cubic_t;
+
+typedef struct pacing_adaptive_s pacing_adaptive_t;
+
+// 拥塞控制算法接口。钩子在对应的公共接口内调用：
+//   on_ack       pacing_adaptive_ack（模型模式的 on_ack_packet 不经过它）
+//   on_loss      pacing_adaptive_report_loss，每个 RTT 至多一次
+//   on_rtt       pacing_adaptive_update_rtt，平滑 RTT 已更新
+//   pacing_rate  每次事件之后取发送速率（bps，0 = 不改变），限制在 [min_bps, max_bps]
+// strict_pacing 为 true 时令牌桶突发限制在约 1ms 的数据量，否则允许 1 个 RTT
+typedef struct {
+    const char *name;
+    bool        strict_pacing;
+    void        (*init)(pacing_adaptive_t *ctx);    // 选用时重置算法状态；除 name 外均可为 NULL
+    void        (*on_ack)(pacing_adaptive_t *ctx, size_t bytes);
+    void        (*on_loss)(pacing_adaptive_t *ctx);
+    void        (*on_rtt)(pacing_adaptive_t *ctx, uint64_t rtt_us);
+    uint64_t    (*pacing_rate)(pacing_adaptive_t *ctx);
+} pacing_cc_ops_t;
+
+extern const pacing_cc_ops_t pacing_cc_reno;
+extern const pacing_cc_ops_t pacing_cc_cubic;
+extern const pacing_cc_ops_t pacing_cc_bbr;
+
+struct pacing_adaptive_s {
     // 基础配置
     uint64_t    target_bps;
     uint64_t    max_bps;
@@ -34,7 +139,7 @@ typedef struct {
     uint64_t    bytes_in_flight;
     uint64_t    last_bw_update_ns;
     
-    // 拥塞控制状态
+    // 拥塞控制状态（reno / cubic 共用）
     enum {
         PACING_SLOW_START,
         PACING_CONGESTION_AVOIDANCE,
@@ -53,16 +158,29 @@ typedef struct {
     uint32_t    jitter_range_ns;
     uint64_t    rng_state;
     
+    // 拥塞控制算法
+    const pacing_cc_ops_t *cc;
+    uint64_t    reno_rate_bps;      // reno 最近给出的速率
+    pacing_cubic_t cubic;
+    bool        model_enabled;      // bbr
+    pacing_model_t model;
+    
     // 统计
     uint64_t    total_bytes;
     uint64_t    total_packets;
     uint64_t    throttled_count;
     uint64_t    burst_count;
-} pacing_adaptive_t;
+};
 
-// 初始化
+// 初始化（算法为 reno，其他算法用 pacing_adaptive_set_cc 选择）
 void pacing_adaptive_init(pacing_adaptive_t *ctx, uint64_t initial_bps);
 
+// 切换拥塞控制算法，保留当前窗口与速率，重置算法自身状态
+void pacing_adaptive_set_cc(pacing_adaptive_t *ctx, const pacing_cc_ops_t *ops);
+
+// 按名称查找算法（reno / cubic / bbr），未知返回 NULL
+const pacing_cc_ops_t* pacing_cc_find(const char *name);
+
 // 设置速率范围
 void pacing_adaptive_set_range(pacing_adaptive_t *ctx, 
                                 uint64_t min_bps, uint64_t max_bps);
@@ -92,6 +210,24 @@ uint64_t pacing_adaptive_get_bw(pacing_adaptive_t *ctx);
 // 允许突发？
 bool pacing_adaptive_allow_burst(pacing_adaptive_t *ctx, size_t bytes);
 
+// =========================================================
+// 模型模式（BBR 式）
+// =========================================================
+// 在 pacing_adaptive_init 之后调用，等同 pacing_adaptive_set_cc(ctx, &pacing_cc_bbr)。开启后：
+//   发送：pacing_adaptive_on_send 代替 pacing_adaptive_commit，记录包快照
+//   确认：pacing_adaptive_on_ack_packet 代替 pacing_adaptive_ack / update_rtt，
+//         交回该包的快照，RTT 由发送时间得出
+//   丢包：pacing_adaptive_ack 扣除在途字节，pacing_adaptive_report_loss 只计数
+//         （模型不因单次丢包降速，只结束当前的带宽探测）
+//   无数据可发时调用 pacing_adaptive_on_app_limited，受应用限制的采样不会拉低带宽估计
+void pacing_adaptive_enable_model(pacing_adaptive_t *ctx);
+
+void pacing_adaptive_on_send(pacing_adaptive_t *ctx, pacing_packet_t *pkt, size_t bytes);
+
+void pacing_adaptive_on_ack_packet(pacing_adaptive_t *ctx, const pacing_packet_t *pkt);
+
+void pacing_adaptive_on_app_limited(pacing_adaptive_t *ctx);
+
 #endif
 
 
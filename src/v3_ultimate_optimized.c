@@ -1,5 +1,7 @@
 
 #define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,6 +17,12 @@
 // =========================================================
 // 配置
 // =========================================================
+typedef enum {
+    BENCH_FORMAT_TABLE,     // 汇总表（人工查看）
+    BENCH_FORMAT_JSON,      // 完整套件，机器可读
+    BENCH_FORMAT_CSV,
+} bench_format_t;
+
 typedef struct {
     // FEC
     bool        fec_enabled;
@@ -27,6 +35,7 @@ typedef struct {
     uint64_t    pacing_initial_bps;
     uint64_t    pacing_min_bps;
     uint64_t    pacing_max_bps;
+    const pacing_cc_ops_t *pacing_cc;   // 新会话默认的拥塞控制算法
     
     // Anti-Detect
     ad_profile_t ad_profile;
@@ -39,6 +48,10 @@ typedef struct {
     // Debug
     bool        verbose;
     bool        benchmark;
+    bench_format_t bench_format;
+    uint8_t     bench_grid[8][2];       // 套件的 (ds, ps) 列表，0 项 = 默认
+    int         bench_grid_count;
+    int         bench_iterations;
 } config_t;
 
 static config_t g_config = {
@@ -51,6 +64,7 @@ static config_t g_config = {
     .pacing_initial_bps = 100 * 1000 * 1000,
     .pacing_min_bps = 1 * 1000 * 1000,
     .pacing_max_bps = 1000 * 1000 * 1000,
+    .pacing_cc = &pacing_cc_cubic,
     
     .ad_profile = AD_PROFILE_NONE,
     .mtu = 1500,
@@ -60,6 +74,7 @@ static config_t g_config = {
     
     .verbose = false,
     .benchmark = false,
+    .bench_format = BENCH_FORMAT_TABLE,
 };
 
 // =========================================================
@@ -76,6 +91,8 @@ static volatile sig_atomic_t g_running = 1;
 static void init_modules(void) {
     // FEC
     if (g_config.fec_enabled) {
+        // AUTO 交给 fec_create 决定，不按本机 CPU / 画像换用二维 XOR 或滑动窗口：
+        // 两者线上格式与 RS 不同且未经协商，只能两端都用 --fec 显式指定
         g_fec = fec_create(g_config.fec_type,
                            g_config.fec_data_shards,
                            g_config.fec_parity_shards);
@@ -90,9 +107,21 @@ static void init_modules(void) {
             case FEC_TYPE_XOR: type_str = "XOR"; break;
             case FEC_TYPE_RS_SIMPLE: type_str = "RS-Simple"; break;
             case FEC_TYPE_RS_SIMD: type_str = "RS-SIMD"; break;
+            case FEC_TYPE_SLIDING: type_str = "Sliding-RLC"; break;
+            case FEC_TYPE_XOR_2D: type_str = "XOR-2D"; break;
+            case FEC_TYPE_RS_CAUCHY: type_str = "RS-Cauchy"; break;
             default: type_str = "Unknown"; break;
             }
-            printf("[FEC] Using %s algorithm\n", type_str);
+            printf("[FEC] Using %s algorithm (%s kernel)\n",
+                   type_str, fec_get_kernel_name(g_fec));
+            
+            fec_mem_stats_t mem;
+            fec_slab_stats_t slab;
+            fec_get_mem_stats(g_fec, &mem);
+            fec_slab_get_stats(&slab);
+            printf("[FEC] Engine memory %zu KB, shard slab limit %zu MB\n",
+                   (mem.engine_bytes + mem.decoder_bytes + mem.shard_bytes) / 1024,
+                   slab.limit >> 20);
         }
     }
     
@@ -102,6 +131,7 @@ static void init_modules(void) {
         pacing_adaptive_set_range(&g_pacing, 
                                    g_config.pacing_min_bps,
                                    g_config.pacing_max_bps);
+        pacing_adaptive_set_cc(&g_pacing, g_config.pacing_cc);
         pacing_adaptive_enable_jitter(&g_pacing, 50000);  // 50µs jitter
     }
     
@@ -119,6 +149,70 @@ static void init_modules(void) {
 // =========================================================
 // 基准测试
 // =========================================================
+static const char* bench_op_str(const fec_bench_result_t *r) {
+    return r->op == FEC_BENCH_ENCODE ? "encode" : "decode";
+}
+
+static const char* bench_pattern_str(const fec_bench_result_t *r) {
+    if (r->op == FEC_BENCH_ENCODE) return "-";
+    switch (r->pattern) {
+    case FEC_BENCH_LOSS_RANDOM: return "random";
+    case FEC_BENCH_LOSS_BURST:  return "burst";
+    default:                    return "none";
+    }
+}
+
+static void bench_report_json(void *user, const fec_bench_result_t *r) {
+    int *count = user;
+    printf("%s\n    {\"impl\": \"%s\", \"ds\": %u, \"ps\": %u, \"shard_size\": %zu, "
+           "\"op\": \"%s\", \"pattern\": \"%s\", \"lost\": %u, \"iterations\": %d, "
+           "\"mbps\": %.1f, \"cycles_per_byte\": %.3f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+           "\"verified\": %s}",
+           (*count)++ ? "," : "",
+           r->impl, r->data_shards, r->parity_shards, r->shard_size,
+           bench_op_str(r), bench_pattern_str(r), r->lost, r->iterations,
+           r->mbps, r->cycles_per_byte, r->p50_ns, r->p99_ns,
+           r->verified ? "true" : "false");
+    fflush(stdout);
+}
+
+static void bench_report_csv(void *user, const fec_bench_result_t *r) {
+    (void)user;
+    printf("%s,%u,%u,%zu,%s,%s,%u,%d,%.1f,%.3f,%.0f,%.0f,%d\n",
+           r->impl, r->data_shards, r->parity_shards, r->shard_size,
+           bench_op_str(r), bench_pattern_str(r), r->lost, r->iterations,
+           r->mbps, r->cycles_per_byte, r->p50_ns, r->p99_ns, r->verified);
+    fflush(stdout);
+}
+
+// 完整套件：编码 + 各丢包模式解码，JSON / CSV 输出便于跨版本对比
+static int run_benchmark_suite(void) {
+    fec_bench_config_t cfg = {
+        .grid = g_config.bench_grid_count ? (const uint8_t (*)[2])g_config.bench_grid : NULL,
+        .grid_count = g_config.bench_grid_count,
+        .iterations = g_config.bench_iterations,
+    };
+    
+    int n;
+    if (g_config.bench_format == BENCH_FORMAT_CSV) {
+        printf("impl,ds,ps,shard_size,op,pattern,lost,iterations,"
+               "mbps,cycles_per_byte,p50_ns,p99_ns,verified\n");
+        n = fec_benchmark_suite(&cfg, bench_report_csv, NULL);
+    } else {
+        int count = 0;
+        printf("{\n  \"simd\": %s,\n  \"results\": [",
+               fec_simd_available() ? "true" : "false");
+        n = fec_benchmark_suite(&cfg, bench_report_json, &count);
+        printf("\n  ]\n}\n");
+    }
+    
+    if (n < 0) {
+        fprintf(stderr, "Benchmark failed: out of memory\n");
+        return 1;
+    }
+    return 0;
+}
+
 static void run_benchmark(void) {
     printf("\n");
     printf("╔═══════════════════════════════════════════════════════════════╗\n");
@@ -127,6 +221,12 @@ static void run_benchmark(void) {
     
     printf("║  SIMD Available: %-5s                                        ║\n",
            fec_simd_available() ? "YES" : "NO");
+    fec_engine_t *probe = fec_create(FEC_TYPE_RS_SIMD, 5, 2);
+    if (probe) {
+        printf("║  GF Kernel:      %-14s                               ║\n",
+               fec_get_kernel_name(probe));
+        fec_destroy(probe);
+    }
     printf("╠═══════════════════════════════════════════════════════════════╣\n");
     
     size_t test_sizes[] = {1000, 5000, 10000, 50000};
@@ -138,11 +238,38 @@ static void run_benchmark(void) {
         double xor_speed = fec_benchmark(FEC_TYPE_XOR, size, iterations);
         double rs_simple_speed = fec_benchmark(FEC_TYPE_RS_SIMPLE, size, iterations);
         double rs_simd_speed = fec_benchmark(FEC_TYPE_RS_SIMD, size, iterations);
+        double rs_cauchy_speed = fec_benchmark(FEC_TYPE_RS_CAUCHY, size, iterations);
         
         printf("║  %5zu bytes:                                                  ║\n", size);
         printf("║    XOR:       %8.1f MB/s                                   ║\n", xor_speed);
         printf("║    RS-Simple: %8.1f MB/s                                   ║\n", rs_simple_speed);
         printf("║    RS-SIMD:   %8.1f MB/s                                   ║\n", rs_simd_speed);
+        printf("║    RS-Cauchy: %8.1f MB/s                                   ║\n", rs_cauchy_speed);
+        
+        // 各 SIMD 内核单独计时，对比标量查表的加速比
+        fec_kernel_result_t kr[8];
+        int nk = fec_benchmark_kernels(size, iterations, kr, 8);
+        for (int k = 0; k < nk; k++) {
+            printf("║      %-13s %8.1f MB/s  (x%5.1f)                     ║\n",
+                   kr[k].name, kr[k].mbps,
+                   rs_simple_speed > 0 ? kr[k].mbps / rs_simple_speed : 0.0);
+        }
+        printf("╠═══════════════════════════════════════════════════════════════╣\n");
+    }
+    
+    // 校验生成循环顺序对比：逐行 vs 列分块（每组 ds 个满 MTU 分片）
+    static const uint8_t configs[][2] = { {10, 4}, {20, 10} };
+    for (size_t c = 0; c < sizeof(configs)/sizeof(configs[0]); c++) {
+        uint8_t ds = configs[c][0], ps = configs[c][1];
+    
+        printf("║  RS %2u:%-2u parity (row -> blocked):                            ║\n", ds, ps);
+        fec_blocked_result_t br[8];
+        int nb = fec_benchmark_blocked(ds, ps, (size_t)ds * 1400, iterations, br, 8);
+        for (int k = 0; k < nb; k++) {
+            printf("║      %-13s %8.1f -> %8.1f MB/s  (x%4.2f)         ║\n",
+                   br[k].name, br[k].row_mbps, br[k].blocked_mbps,
+                   br[k].row_mbps > 0 ? br[k].blocked_mbps / br[k].row_mbps : 0.0);
+        }
         printf("╠═══════════════════════════════════════════════════════════════╣\n");
     }
     
@@ -155,11 +282,14 @@ static void run_benchmark(void) {
 static void usage(const char *prog) {
     printf("Usage: %s [OPTIONS]\n\n", prog);
     printf("FEC Options:\n");
-    printf("  --fec[=TYPE]          Enable FEC (auto|xor|rs|rs-simd)\n");
+    printf("  --fec[=TYPE]          Enable FEC (auto|xor|xor2d|rs|rs-simd|sliding|cauchy)\n");
     printf("  --fec-shards=D:P      Data:Parity shards (default: 5:2)\n");
+    printf("                        sliding: repair every D packets, P repairs each\n");
+    printf("                        xor2d: D packets per row, P rows per block\n");
     printf("\nPacing Options:\n");
     printf("  --pacing=MBPS         Initial pacing rate\n");
     printf("  --pacing-range=MIN:MAX  Rate range in Mbps\n");
+    printf("  --cc=ALG              Congestion control (reno|cubic|bbr, default: cubic)\n");
     printf("\nAnti-Detect Options:\n");
     printf("  --profile=TYPE        https|video|voip|gaming\n");
     printf("  --mtu=SIZE            MTU size (default: 1500)\n");
@@ -167,28 +297,71 @@ static void usage(const char *prog) {
     printf("  -p, --port=PORT       Listen port\n");
     printf("  -b, --bind=ADDR       Bind address\n");
     printf("  -v, --verbose         Verbose output\n");
-    printf("  --benchmark           Run FEC benchmark\n");
+    printf("  --benchmark[=FMT]     Run FEC benchmark (table|json|csv)\n");
+    printf("                        json/csv: encode + decode suite per kernel\n");
+    printf("  --bench-grid=D:P,...  Suite shard grid, up to 8 entries (default: 5:2,10:4,20:10)\n");
+    printf("  --bench-iter=N        Suite calls per measurement (default: 2000)\n");
     printf("  -h, --help            Show help\n");
 }
 
+// 十进制无符号数，不接受空串、符号与前导空白；*end 指向数字之后
+static bool parse_ulong(const char *s, unsigned long max, unsigned long *out, char **end) {
+    if (*s < '0' || *s > '9') return false;
+    errno = 0;
+    unsigned long v = strtoul(s, end, 10);
+    if (errno || v > max) return false;
+    *out = v;
+    return true;
+}
+
+// D:P[,D:P...]，每项须为 fec_create 接受的分片数，超出列表容量视为错误
+static int parse_bench_grid(const char *arg) {
+    const int max_count = sizeof(g_config.bench_grid) / sizeof(g_config.bench_grid[0]);
+    const char *p = arg;
+    int count = 0;
+    
+    for (;;) {
+        unsigned long ds, ps;
+        char *end;
+        if (count == max_count) return -1;
+        if (!parse_ulong(p, FEC_MAX_DATA_SHARDS, &ds, &end) || ds == 0 || *end != ':') return -1;
+        if (!parse_ulong(end + 1, FEC_MAX_PARITY_SHARDS, &ps, &end) || ps == 0) return -1;
+        if (ds + ps > FEC_MAX_TOTAL_SHARDS) return -1;
+        
+        g_config.bench_grid[count][0] = ds;
+        g_config.bench_grid[count][1] = ps;
+        count++;
+        
+        if (*end == '\0') break;
+        if (*end != ',') return -1;
+        p = end + 1;
+    }
+    
+    g_config.bench_grid_count = count;
+    return 0;
+}
+
 static void parse_args(int argc, char **argv) {
     static struct option long_opts[] = {
         {"fec",         optional_argument, 0, 'f'},
         {"fec-shards",  required_argument, 0, 'F'},
         {"pacing",      required_argument, 0, 'P'},
         {"pacing-range", required_argument, 0, 'R'},
+        {"cc",          required_argument, 0, 'C'},
         {"profile",     required_argument, 0, 'A'},
         {"mtu",         required_argument, 0, 'M'},
         {"port",        required_argument, 0, 'p'},
         {"bind",        required_argument, 0, 'b'},
         {"verbose",     no_argument,       0, 'v'},
-        {"benchmark",   no_argument,       0, 'B'},
+        {"benchmark",   optional_argument, 0, 'B'},
+        {"bench-grid",  required_argument, 0, 'G'},
+        {"bench-iter",  required_argument, 0, 'I'},
         {"help",        no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "f::F:P:R:A:M:p:b:vBh", 
+    while ((opt = getopt_long(argc, argv, "f::F:P:R:C:A:M:p:b:vB::G:I:h", 
                               long_opts, NULL)) != -1) {
         switch (opt) {
         case 'f':
@@ -196,10 +369,16 @@ static void parse_args(int argc, char **argv) {
             if (optarg) {
                 if (strcmp(optarg, "xor") == 0) {
                     g_config.fec_type = FEC_TYPE_XOR;
+                } else if (strcmp(optarg, "xor2d") == 0) {
+                    g_config.fec_type = FEC_TYPE_XOR_2D;
                 } else if (strcmp(optarg, "rs") == 0) {
                     g_config.fec_type = FEC_TYPE_RS_SIMPLE;
                 } else if (strcmp(optarg, "rs-simd") == 0) {
                     g_config.fec_type = FEC_TYPE_RS_SIMD;
+                } else if (strcmp(optarg, "sliding") == 0) {
+                    g_config.fec_type = FEC_TYPE_SLIDING;
+                } else if (strcmp(optarg, "cauchy") == 0) {
+                    g_config.fec_type = FEC_TYPE_RS_CAUCHY;
                 } else {
                     g_config.fec_type = FEC_TYPE_AUTO;
                 }
@@ -225,6 +404,14 @@ static void parse_args(int argc, char **argv) {
             break;
         }
             
+        case 'C':
+            g_config.pacing_cc = pacing_cc_find(optarg);
+            if (!g_config.pacing_cc) {
+                fprintf(stderr, "Unknown congestion control: %s\n", optarg);
+                exit(1);
+            }
+            break;
+            
         case 'A':
             if (strcmp(optarg, "https") == 0) {
                 g_config.ad_profile = AD_PROFILE_HTTPS;
@@ -255,7 +442,40 @@ static void parse_args(int argc, char **argv) {
             
         case 'B':
             g_config.benchmark = true;
+            if (!optarg || strcmp(optarg, "table") == 0) {
+                g_config.bench_format = BENCH_FORMAT_TABLE;
+            } else if (strcmp(optarg, "json") == 0) {
+                g_config.bench_format = BENCH_FORMAT_JSON;
+            } else if (strcmp(optarg, "csv") == 0) {
+                g_config.bench_format = BENCH_FORMAT_CSV;
+            } else {
+                fprintf(stderr, "Unknown benchmark format: %s\n", optarg);
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+            
+        case 'G':
+            if (parse_bench_grid(optarg) < 0) {
+                fprintf(stderr, "Invalid --bench-grid: %s (D:P, D 1-%d, P 1-%d, D+P <= %d, at most %d entries)\n",
+                        optarg, FEC_MAX_DATA_SHARDS, FEC_MAX_PARITY_SHARDS, FEC_MAX_TOTAL_SHARDS,
+                        (int)(sizeof(g_config.bench_grid) / sizeof(g_config.bench_grid[0])));
+                usage(argv[0]);
+                exit(1);
+            }
+            break;
+            
+        case 'I': {
+            unsigned long n;
+            char *end;
+            if (!parse_ulong(optarg, INT_MAX, &n, &end) || n == 0 || *end != '\0') {
+                fprintf(stderr, "Invalid --bench-iter: %s\n", optarg);
+                usage(argv[0]);
+                exit(1);
+            }
+            g_config.bench_iterations = (int)n;
             break;
+        }
             
         case 'h':
         default:
@@ -280,6 +500,7 @@ int main(int argc, char **argv) {
     parse_args(argc, argv);
     
     if (g_config.benchmark) {
+        if (g_config.bench_format != BENCH_FORMAT_TABLE) return run_benchmark_suite();
         run_benchmark();
         return 0;
     }
@@ -305,7 +526,8 @@ int main(int argc, char **argv) {
     printf("                          ║\n");
     printf("║  Pacing:      %-5s", g_config.pacing_enabled ? "ON" : "OFF");
     if (g_config.pacing_enabled) {
-        printf("  (Adaptive, %lu-%lu Mbps)",
+        printf("  (%s, %lu-%lu Mbps)",
+               g_config.pacing_cc->name,
                g_config.pacing_min_bps / 1000000,
                g_config.pacing_max_bps / 1000000);
     }